@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <vector>
+
+#include "bench.h"
+#include "sphere_store.h"
+
+// How spheres were animated before SphereStore: one record per sphere and
+// glm's sin and cos of the angle in radians.
+static void animateRecords(std::vector<AnimatedSphereData>& spheres,
+                           const float& time) {
+  for (auto& sphere : spheres) {
+    const auto angle{glm::radians(time * sphere.speed + sphere.cycleOffset)};
+    sphere.sphereData.position.x =
+        sphere.originalPosition.x + glm::sin(angle) * sphere.movingScale.x;
+    sphere.sphereData.position.z =
+        sphere.originalPosition.z + glm::cos(angle) * sphere.movingScale.z;
+  }
+}
+
+// Worst error of the kernel against double-precision sin and cos over a few
+// times spread across the 360 s period.
+static double kernelError(SphereStore& spheres) {
+  auto error{0.0};
+  for (const auto time : {0.0f, 1.37f, 100.5f, 359.99f}) {
+    animateSpheres(spheres, time);
+    for (size_t i = 0; i < spheres.size(); i++) {
+      const auto angle{(static_cast<double>(time) * spheres.speed[i] +
+                        spheres.cycleOffset[i]) *
+                       std::numbers::pi / 180.0};
+      error = std::max(
+          {error,
+           std::abs(spheres.positionX[i] - spheres.originX[i] -
+                    std::sin(angle) * spheres.scaleX[i]),
+           std::abs(spheres.positionZ[i] - spheres.originZ[i] -
+                    std::cos(angle) * spheres.scaleZ[i])});
+    }
+  }
+  return error;
+}
+
+// Nanoseconds per sphere of one frame's animation, for the records and for
+// the store, at scene sizes from the default to a million spheres.
+void runAnimationBench() {
+  constexpr uint64_t seed{1};
+  for (const size_t count : {1'000, 100'000, 1'000'000}) {
+    SphereStore spheres{};
+    generateSpheres(spheres, seed, count);
+    std::vector<AnimatedSphereData> records(count);
+    for (size_t i = 0; i < count; i++)
+      records[i] = {.originalPosition{spheres.originX[i], spheres.originY[i],
+                                      spheres.originZ[i]},
+                    .movingScale{spheres.scaleX[i], 0.0f, spheres.scaleZ[i]},
+                    .cycleOffset{spheres.cycleOffset[i]},
+                    .sphereData{},
+                    .speed{spheres.speed[i]}};
+
+    const auto frames{std::max<size_t>(20'000'000 / count, 20)};
+    auto time{0.0f};
+    const auto recordTime{nanosecondsPerCall(frames, [&] {
+      animateRecords(records, time += 0.016f);
+    })};
+    time = 0.0f;
+    const auto storeTime{nanosecondsPerCall(frames, [&] {
+      animateSpheres(spheres, time += 0.016f);
+    })};
+    const auto perSphere{static_cast<double>(count)};
+    std::cout << count << " spheres: records "
+              << recordTime / perSphere << " ns/sphere, store "
+              << storeTime / perSphere << " ns/sphere" << std::endl;
+  }
+
+  SphereStore spheres{};
+  generateSpheres(spheres, seed, 100'000);
+  std::cout << "max error vs double sin/cos: " << kernelError(spheres)
+            << std::endl;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+// Wall time per call of body in nanoseconds, over calls calls after one
+// untimed call that warms caches and lazily built state.
+template <typename Body>
+double nanosecondsPerCall(const size_t& calls, const Body& body) {
+  body();
+  const auto start{std::chrono::steady_clock::now()};
+  for (size_t i = 0; i < calls; i++) body();
+  const std::chrono::duration<double, std::nano> elapsed{
+      std::chrono::steady_clock::now() - start};
+  return elapsed.count() / static_cast<double>(calls);
+}
+
+void runUniformBench();
+void runAnimationBench();
+void runGridBench();
+void runPhysicsBench();
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+#include "bench.h"
+#include "counter_rng.h"
+#include "sphere_grid.h"
+
+// The spheres of one run: all the same radius, with centers spread over the
+// room and heights up to maxHeight.
+struct GridBenchLayout {
+  float radius;
+  float maxHeight;
+};
+
+static SphereStore makeSpheres(const GridBenchLayout& layout,
+                               const size_t& count) {
+  SphereStore spheres{};
+  spheres.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    CounterRng rng{7, i};
+    spheres.positionX[i] = rng.uniform(-0.95f, 0.95f);
+    spheres.positionY[i] = rng.uniform(0.05f, 0.05f + layout.maxHeight);
+    spheres.positionZ[i] = rng.uniform(-0.95f, 0.95f);
+    spheres.radius[i] = layout.radius;
+  }
+  return spheres;
+}
+
+static std::vector<uint32_t> linearRadius(const SphereStore& spheres,
+                                          const glm::vec3& center,
+                                          const float& radius) {
+  std::vector<uint32_t> result{};
+  for (uint32_t i = 0; i < spheres.size(); i++) {
+    const glm::vec3 position{spheres.positionX[i], spheres.positionY[i],
+                             spheres.positionZ[i]};
+    if (glm::length(position - center) <= radius + spheres.radius[i])
+      result.push_back(i);
+  }
+  return result;
+}
+
+static std::optional<SphereHit> linearRaycast(const SphereStore& spheres,
+                                              const glm::vec3& origin,
+                                              const glm::vec3& direction) {
+  std::optional<SphereHit> nearest{};
+  for (uint32_t i = 0; i < spheres.size(); i++) {
+    const glm::vec3 toCenter{spheres.positionX[i] - origin.x,
+                             spheres.positionY[i] - origin.y,
+                             spheres.positionZ[i] - origin.z};
+    const auto along{glm::dot(toCenter, direction)};
+    const auto discriminant{along * along - glm::dot(toCenter, toCenter) +
+                            spheres.radius[i] * spheres.radius[i]};
+    if (discriminant < 0.0f) continue;
+    auto distance{along - std::sqrt(discriminant)};
+    if (distance < 0.0f) distance = along + std::sqrt(discriminant);
+    if (distance >= 0.0f && (!nearest || distance < nearest->distance))
+      nearest = SphereHit{.index{i}, .distance{distance}};
+  }
+  return nearest;
+}
+
+// Builds the grid over a million spheres and times each query against the
+// linear scan it replaces, counting the queries whose results differ.
+void runGridBench() {
+  constexpr size_t count{1'000'000};
+  constexpr size_t queryCount{200};
+  constexpr auto queryRadius{0.05f};
+  constexpr GridBenchLayout layouts[]{
+      {.radius{0.05f}, .maxHeight{0.0f}},
+      {.radius{0.05f}, .maxHeight{1.1f}},
+      {.radius{0.002f}, .maxHeight{1.1f}}};
+
+  for (const auto& layout : layouts) {
+    const auto spheres{makeSpheres(layout, count)};
+    SphereGrid grid{glm::vec2{-1.0f}, glm::vec2{1.0f}};
+    const auto buildTime{
+        nanosecondsPerCall(10, [&] { grid.build(spheres); })};
+    std::cout << "radius " << layout.radius << ", heights up to "
+              << 0.05f + layout.maxHeight << ": " << grid.cellsPerSide()
+              << " cells per side, build " << buildTime / 1e6 << " ms"
+              << std::endl;
+
+    std::vector<glm::vec3> centers(queryCount);
+    std::vector<glm::vec3> directions(queryCount);
+    std::vector<Frustum> frusta(queryCount);
+    for (size_t i = 0; i < queryCount; i++) {
+      CounterRng rng{11, i};
+      centers[i] = {rng.uniform(-0.9f, 0.9f), rng.uniform(0.0f, 1.1f),
+                    rng.uniform(-0.9f, 0.9f)};
+      directions[i] = glm::normalize(
+          glm::vec3{rng.uniform(-1.0f, 1.0f), rng.uniform(-0.3f, 0.3f),
+                    rng.uniform(-1.0f, 1.0f)});
+      const glm::vec3 eye{centers[i].x, 0.6f, centers[i].z};
+      frusta[i] = Frustum{
+          glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) *
+          glm::lookAt(eye, eye + directions[i] - glm::vec3{0.0f, 0.2f, 0.0f},
+                      glm::vec3{0.0f, 1.0f, 0.0f})};
+    }
+
+    std::vector<uint32_t> result{};
+    size_t query{};
+    const auto gridRadiusTime{nanosecondsPerCall(queryCount, [&] {
+      grid.queryRadius(centers[query++ % queryCount], queryRadius, result);
+    })};
+    const auto gridFrustumTime{nanosecondsPerCall(queryCount, [&] {
+      grid.queryFrustum(frusta[query++ % queryCount], result);
+    })};
+    const auto gridRayTime{nanosecondsPerCall(queryCount, [&] {
+      grid.raycast(centers[query % queryCount],
+                   directions[query % queryCount]);
+      query++;
+    })};
+
+    std::vector<BoundingSphere> bounds(count);
+    for (size_t i = 0; i < count; i++)
+      bounds[i] = {spheres.positionX[i], spheres.positionY[i],
+                   spheres.positionZ[i], spheres.radius[i]};
+    std::vector<uint8_t> visible(count);
+    const auto linearFrustumTime{nanosecondsPerCall(20, [&] {
+      frusta[query++ % queryCount].intersects(bounds, visible);
+    })};
+    const auto linearRadiusTime{nanosecondsPerCall(20, [&] {
+      linearRadius(spheres, centers[query++ % queryCount], queryRadius);
+    })};
+    const auto linearRayTime{nanosecondsPerCall(20, [&] {
+      linearRaycast(spheres, centers[query % queryCount],
+                    directions[query % queryCount]);
+      query++;
+    })};
+
+    size_t radiusMismatches{};
+    size_t frustumMismatches{};
+    size_t rayMismatches{};
+    for (size_t i = 0; i < queryCount; i++) {
+      grid.queryRadius(centers[i], queryRadius, result);
+      std::sort(result.begin(), result.end());
+      radiusMismatches += result != linearRadius(spheres, centers[i],
+                                                 queryRadius);
+
+      grid.queryFrustum(frusta[i], result);
+      std::sort(result.begin(), result.end());
+      frusta[i].intersects(bounds, visible);
+      std::vector<uint32_t> expected{};
+      for (uint32_t j = 0; j < count; j++)
+        if (visible[j]) expected.push_back(j);
+      frustumMismatches += result != expected;
+
+      const auto hit{grid.raycast(centers[i], directions[i])};
+      const auto expectedHit{
+          linearRaycast(spheres, centers[i], directions[i])};
+      rayMismatches +=
+          hit.has_value() != expectedHit.has_value() ||
+          (hit && hit->index != expectedHit->index &&
+           std::abs(hit->distance - expectedHit->distance) > 1e-6f);
+    }
+
+    std::cout << "  radius:  grid " << gridRadiusTime / 1e6 << " ms, linear "
+              << linearRadiusTime / 1e6 << " ms, " << radiusMismatches
+              << " mismatches" << std::endl
+              << "  frustum: grid " << gridFrustumTime / 1e6
+              << " ms, linear " << linearFrustumTime / 1e6 << " ms, "
+              << frustumMismatches << " mismatches" << std::endl
+              << "  ray:     grid " << gridRayTime / 1e6 << " ms, linear "
+              << linearRayTime / 1e6 << " ms, " << rayMismatches
+              << " mismatches" << std::endl;
+  }
+}
@@ -0,0 +1,26 @@
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+#include "bench.h"
+
+// Runs the benchmarks named on the command line, or all of them. Shaders are
+// loaded from src/shaders, so run it from the repository root.
+int main(int argc, char* argv[]) {
+  constexpr std::array<std::pair<std::string_view, void (*)()>, 4> benches{
+      {{"uniforms", runUniformBench},
+       {"animation", runAnimationBench},
+       {"grid", runGridBench},
+       {"physics", runPhysicsBench}}};
+
+  for (const auto& [name, run] : benches) {
+    auto isSelected{argc == 1};
+    for (int i = 1; i < argc; i++) isSelected |= name == argv[i];
+    if (!isSelected) continue;
+    std::cout << "== " << name << std::endl;
+    run();
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+#include "bench.h"
+#include "scene.h"
+#include "sphere_physics.h"
+
+// Generated spheres shrunk to the given radius, so larger counts still fit
+// on the floor.
+static SphereStore makeSpheres(const size_t& count, const float& radius) {
+  SphereStore spheres{};
+  generateSpheres(spheres, 3, count);
+  std::fill(spheres.radius.begin(), spheres.radius.end(), radius);
+  return spheres;
+}
+
+// Milliseconds per physics step at scene sizes up to 100k spheres in the
+// default room, after a few steps that let the first contacts settle. The
+// timed run is repeated step for step to check it ends where it did the
+// first time.
+void runPhysicsBench() {
+  constexpr size_t settleSteps{30};
+  constexpr std::pair<size_t, float> scenes[]{
+      {100, 0.05f}, {10'000, 0.005f}, {100'000, 0.0015f}};
+
+  const auto room{roomBounds(defaultStaticLayout())};
+  std::cout << std::max(std::thread::hardware_concurrency(), 1u)
+            << " hardware threads" << std::endl;
+  for (const auto& [count, radius] : scenes) {
+    const auto steps{count >= 100'000 ? size_t{120} : size_t{600}};
+    auto spheres{makeSpheres(count, radius)};
+    SpherePhysics physics{room.min, room.max};
+    physics.start(spheres, 1.0f);
+    // The untimed first call of nanosecondsPerCall is the last settling step.
+    for (size_t i = 1; i < settleSteps; i++) physics.step(spheres);
+    const auto stepTime{
+        nanosecondsPerCall(steps, [&] { physics.step(spheres); })};
+
+    auto replayed{makeSpheres(count, radius)};
+    SpherePhysics replay{room.min, room.max};
+    replay.start(replayed, 1.0f);
+    for (size_t i = 0; i < settleSteps + steps; i++) replay.step(replayed);
+    const auto isDeterministic{
+        std::memcmp(spheres.positionX.data(), replayed.positionX.data(),
+                    count * sizeof(float)) == 0 &&
+        std::memcmp(spheres.positionZ.data(), replayed.positionZ.data(),
+                    count * sizeof(float)) == 0};
+
+    std::cout << count << " spheres of radius " << radius << ": "
+              << stepTime / 1e6 << " ms/step, "
+              << stepTime / static_cast<double>(count) << " ns/sphere, "
+              << (isDeterministic ? "deterministic" : "NOT deterministic")
+              << std::endl;
+  }
+}
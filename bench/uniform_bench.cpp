@@ -0,0 +1,65 @@
+#include <iostream>
+#include <string>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench.h"
+#include "raii_glfw.h"
+#include "shader.h"
+
+// How uniforms were set before locations were reflected: bind the program,
+// then look the location up by name on every call.
+static void setUniformByName(const GLuint& shaderProgram,
+                             const std::string& name, const glm::mat4& data) {
+  glUseProgram(shaderProgram);
+  glUniformMatrix4fv(glGetUniformLocation(shaderProgram, name.c_str()), 1,
+                     GL_FALSE, glm::value_ptr(data));
+}
+
+static void setUniformByName(const GLuint& shaderProgram,
+                             const std::string& name, const glm::vec4& data) {
+  glUseProgram(shaderProgram);
+  glUniform4fv(glGetUniformLocation(shaderProgram, name.c_str()), 1,
+               glm::value_ptr(data));
+}
+
+// Sets the model and color uniforms of the basic program the way a draw
+// does, by name lookup and through the reflected location table.
+void runUniformBench() {
+  constexpr size_t calls{2'000'000};
+  const RaiiGlfw raiiGlfw{};
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  const auto window{glfwCreateWindow(64, 64, "bench", nullptr, nullptr)};
+  if (window == NULL) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    return;
+  }
+  glfwMakeContextCurrent(window);
+  if (!gladLoadGL()) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return;
+  }
+
+  const BasicShaderProgramProvider provider{};
+  const auto program{provider.program()};
+  RenderState::useProgram(program);
+  glm::mat4 model{1.0f};
+  glm::vec4 color{1.0f};
+
+  const auto byName{nanosecondsPerCall(calls, [&] {
+    model[3].x += 1.0f;
+    setUniformByName(program, "model", model);
+    setUniformByName(program, "color", color);
+  })};
+  const auto byKey{nanosecondsPerCall(calls, [&] {
+    model[3].x += 1.0f;
+    setUniformToProgram(program, "model", model);
+    setUniformToProgram(program, "color", color);
+  })};
+  glFinish();
+  std::cout << "by name: " << byName / 2.0 << " ns per uniform" << std::endl
+            << "by key:  " << byKey / 2.0 << " ns per uniform" << std::endl;
+  glfwDestroyWindow(window);
+}
@@ -3,7 +3,7 @@
 const GLuint& AxesVaoProvider::vao() const {
   static auto _ = std::invoke([this] {
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    RenderState::bindVertexArray(_vao);
 
     GLuint vbo{};
     glGenBuffers(1, &vbo);
@@ -23,25 +23,18 @@ const GLuint& AxesVaoProvider::vao() const {
   return _vao;
 }
 
-AxesComponent::AxesComponent() {
-  setUniformToProgram(shaderProgramProvider.program(), "model", glm::mat4(1.0));
-}
-
-void AxesComponent::render(const glm::mat4& view, const glm::mat4& proj) const {
-  glBindVertexArray(VaoProvider.vao());
-  glUseProgram(shaderProgramProvider.program());
-  setUniformToProgram(shaderProgramProvider.program(), "view", view);
-  setUniformToProgram(shaderProgramProvider.program(), "proj", proj);
-
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{1.0, 0.0, 0.0, 1.0});
-  glDrawArrays(GL_LINES, 0, 2);
-
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{0.0, 1.0, 0.0, 1.0});
-  glDrawArrays(GL_LINES, 2, 2);
-
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{0.0, 0.0, 1.0, 1.0});
-  glDrawArrays(GL_LINES, 4, 2);
+void AxesComponent::enqueue(RenderQueue& queue) const {
+  if (!queue.isVisible(bounds)) return;
+
+  const std::array<glm::vec4, 3> colors{glm::vec4{1.0, 0.0, 0.0, 1.0},
+                                        glm::vec4{0.0, 1.0, 0.0, 1.0},
+                                        glm::vec4{0.0, 0.0, 1.0, 1.0}};
+  for (GLint i = 0; i < 3; i++)
+    queue.push({.program{queue.programOf(shaderProgramProvider)},
+                .vao{VaoProvider.vao()},
+                .primitive{GL_LINES},
+                .first{i * 2},
+                .count{2},
+                .instanceCount{queue.viewCount()},
+                .color{colors[i]}});
 };
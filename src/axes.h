@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 #include <glm/matrix.hpp>
 
+#include "render_queue.h"
 #include "shader.h"
 
 class AxesVaoProvider {
@@ -16,10 +17,10 @@ private:
 
 class AxesComponent {
 public:
-  AxesComponent();
-  void render(const glm::mat4& view, const glm::mat4& proj) const;
+  void enqueue(RenderQueue& queue) const;
 
 private:
   static inline const BasicShaderProgramProvider shaderProgramProvider{};
   static inline const AxesVaoProvider VaoProvider{};
+  static inline const BoundingSphere bounds{0.0f, 0.0f, 0.0f, 1.0f};
 };
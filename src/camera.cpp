@@ -5,7 +5,7 @@ UserControlData CameraComponent::userData;
 const GLuint& CameraVaoProvider::vao() const {
   static auto _ = std::invoke([this] {
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    RenderState::bindVertexArray(_vao);
 
     GLuint vbo{};
     glGenBuffers(1, &vbo);
@@ -91,42 +91,32 @@ void CameraComponent::updateUserControlData(const UserControlData& userData) {
   CameraComponent::userData = userData;
 }
 
-CameraComponent::CameraComponent(const glm::vec3& position) {
+CameraComponent::CameraComponent(const glm::vec3& position)
+    : position(position) {
   model = glm::translate(model, position);
-  model = glm::scale(model, glm::vec3{0.05f, 0.05f, 0.05f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightAmbient",
-                      glm::vec3{0.2f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightDiffuse",
-                      glm::vec3{1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightSpecular",
-                      glm::vec3{1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "luminousIntensity",
-                      GLfloat(1));
+  model = glm::scale(model, glm::vec3{scale});
 }
 
-void CameraComponent::render(const glm::mat4& view, const glm::mat4& proj,
-                             double horizontalAngleRadians,
-                             double verticalAngleRadians,
-                             const glm::vec3& viewPosition,
-                             const glm::vec3& lightPosition) const {
-  glBindVertexArray(vaoProvider.vao());
-  glUseProgram(shaderProgramProvider.program());
-  model = glm::rotate(model, static_cast<float>(horizontalAngleRadians),
-                      glm::vec3{0.0f, 1.0f, 0.0f});
-  model = glm::rotate(model, static_cast<float>(verticalAngleRadians),
-                      glm::vec3{-1.0f, 0.0f, 0.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{0.2, 0.2, 0.2, 1.0});
-  setUniformToProgram(shaderProgramProvider.program(), "model", model);
-  setUniformToProgram(shaderProgramProvider.program(), "view", view);
-  setUniformToProgram(shaderProgramProvider.program(), "proj", proj);
-  setUniformToProgram(shaderProgramProvider.program(), "viewPosition",
-                      viewPosition);
-  setUniformToProgram(shaderProgramProvider.program(), "lightPosition",
-                      lightPosition);
-
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+void CameraComponent::enqueue(RenderQueue& queue,
+                              double horizontalAngleRadians,
+                              double verticalAngleRadians) const {
+  if (!queue.isVisible(BoundingSphere{position, radius})) return;
+
+  auto rotatedModel{glm::rotate(model,
+                                static_cast<float>(horizontalAngleRadians),
+                                glm::vec3{0.0f, 1.0f, 0.0f})};
+  rotatedModel = glm::rotate(rotatedModel,
+                             static_cast<float>(verticalAngleRadians),
+                             glm::vec3{-1.0f, 0.0f, 0.0f});
 
   for (GLint i = 0; i < numSurfaces; i++)
-    glDrawArrays(GL_TRIANGLE_FAN, i * numPointsOfSurface, numPointsOfSurface);
+    queue.push({.program{queue.programOf(shaderProgramProvider)},
+                .vao{vaoProvider.vao()},
+                .primitive{GL_TRIANGLE_FAN},
+                .first{i * numPointsOfSurface},
+                .count{numPointsOfSurface},
+                .instanceCount{queue.viewCount()},
+                .center{position},
+                .model{rotatedModel},
+                .color{glm::vec4{0.2, 0.2, 0.2, 1.0}}});
 };
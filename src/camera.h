@@ -6,6 +6,7 @@
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "render_queue.h"
 #include "shader.h"
 #include "user_control.h"
 
@@ -23,10 +24,8 @@ private:
 class CameraComponent {
 public:
   CameraComponent(const glm::vec3& position);
-  void render(const glm::mat4& view, const glm::mat4& proj,
-              double horizontalAngleRadians, double verticalAngleRadians,
-              const glm::vec3& viewPosition,
-              const glm::vec3& lightPosition) const;
+  void enqueue(RenderQueue& queue, double horizontalAngleRadians,
+               double verticalAngleRadians) const;
   void render(const glm::mat4& view, const glm::mat4& proj,
               const glm::vec3& viewPosition, const glm::vec3& lightPosition,
               UserControlData& userData) const;
@@ -35,6 +34,10 @@ public:
 private:
   static inline const LightingShaderProgramProvider shaderProgramProvider{};
   static inline const CameraVaoProvider vaoProvider{};
-  mutable glm::mat4 model{1.0};
+  static constexpr float scale{0.05f};
+  // The farthest corner of the lens hood, (1, 1, 3) before scaling.
+  static constexpr float radius{scale * 3.3167f};
+  glm::vec3 position{};
+  glm::mat4 model{1.0};
   static UserControlData userData;
 };
@@ -0,0 +1,46 @@
+#include "counter_rng.h"
+
+// The low half of the counter is the stream and the high half the block
+// within it.
+CounterRng::CounterRng(const uint64_t& seed, const uint64_t& stream) noexcept
+    : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+      counter{static_cast<uint32_t>(stream),
+              static_cast<uint32_t>(stream >> 32), 0, 0} {}
+
+uint32_t CounterRng::next() noexcept {
+  if (used == block.size()) {
+    constexpr uint64_t multiplier0{0xD2511F53};
+    constexpr uint64_t multiplier1{0xCD9E8D57};
+    constexpr uint32_t weyl0{0x9E3779B9};
+    constexpr uint32_t weyl1{0xBB67AE85};
+
+    block = counter;
+    auto roundKey{key};
+    for (int round = 0; round < 10; round++) {
+      const auto product0{multiplier0 * block[0]};
+      const auto product1{multiplier1 * block[2]};
+      block = {static_cast<uint32_t>(product1 >> 32) ^ block[1] ^ roundKey[0],
+               static_cast<uint32_t>(product1),
+               static_cast<uint32_t>(product0 >> 32) ^ block[3] ^ roundKey[1],
+               static_cast<uint32_t>(product0)};
+      roundKey[0] += weyl0;
+      roundKey[1] += weyl1;
+    }
+
+    if (++counter[2] == 0) counter[3]++;
+    used = 0;
+  }
+  return block[used++];
+}
+
+// The top 24 bits, which a float holds exactly, scaled to [low, high).
+float CounterRng::uniform(const float& low, const float& high) noexcept {
+  const auto unit{static_cast<float>(next() >> 8) * (1.0f / 16777216.0f)};
+  return low + (high - low) * unit;
+}
+
+// Lemire's multiply-shift: [0, bound) without a division, with a bias too
+// small to matter for bounds this far below 2^32.
+uint32_t CounterRng::below(const uint32_t& bound) noexcept {
+  return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+}
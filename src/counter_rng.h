@@ -0,0 +1,22 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): every block of four numbers is a keyed hash of its position in the
+// sequence, so a stream is fully set by its seed and stream number. Giving
+// each item its own stream makes generated data the same however the items
+// are split over threads.
+class CounterRng {
+public:
+  CounterRng(const uint64_t& seed, const uint64_t& stream) noexcept;
+  uint32_t next() noexcept;
+  float uniform(const float& low, const float& high) noexcept;
+  uint32_t below(const uint32_t& bound) noexcept;
+
+private:
+  std::array<uint32_t, 2> key{};
+  std::array<uint32_t, 4> counter{};
+  std::array<uint32_t, 4> block{};
+  size_t used{4};
+};
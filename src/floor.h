@@ -1,34 +1,21 @@
 #pragma once
 #include <array>
-#include <cstddef>
-#include <string>
 
-#include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "shader.h"
-#include "texture.h"
-
-class FloorVaoProvider {
-public:
-  const GLuint& vao() const;
-
-private:
-  mutable GLuint _vao{};
-};
+#include "static_batch.h"
 
+// A floor or ceiling tile, only kept until the scene has baked it.
 class FloorComponent {
 public:
+  static constexpr char textureFile[]{"textures/tile2.jpeg"};
+
   FloorComponent(const glm::vec3& position);
-  void render(const glm::mat4& view, const glm::mat4& proj,
-              const glm::vec3& viewPosition,
-              const glm::vec3& lightPosition) const;
+  FloorComponent(const glm::mat4& model);
+  const glm::mat4& model() const noexcept;
+  void bake(StaticBatch& batch) const;
 
 private:
-  static inline const TextureLightingShaderProgramProvider
-      shaderProgramProvider{};
-  static inline const FloorVaoProvider vaoProvider{};
-  static inline const TextureProvider textureProvider{
-      std::string("textures/tile2.jpeg")};
-  glm::mat4 model{1.0};
+  static const std::array<TexturedVertex, 24> vertices;
+  glm::mat4 _model{1.0};
 };
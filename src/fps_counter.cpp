@@ -12,9 +12,62 @@ void FpsCounter::updateFramerate(double currentTimestamp) {
   } else [[unlikely]] {
     double framerate = frameCount / delta;
     referenceTimestamp = currentTimestamp;
+
+    const auto& counters{RenderState::counters()};
+    const auto frames{static_cast<uint64_t>(std::max(frameCount, 1))};
+    const auto issued{(counters.issued - lastCounters.issued) / frames};
+    const auto elided{(counters.elided - lastCounters.elided) / frames};
+    lastCounters = counters;
+    const auto visible{cullTotals.visible / frames};
+    const auto culled{cullTotals.culled / frames};
+    cullTotals = {};
+    const auto demoted{lodTotals.demoted / frames};
+    const auto dropped{lodTotals.dropped / frames};
+    lodTotals = {};
+    const auto sphereCullMs{sphereCullTotal * 1000.0 / frames};
+    sphereCullTotal = 0.0;
+    const auto tickMs{simulationTotals.tickSeconds * 1000.0 / frames};
+    const auto snapshotAgeMs{simulationTotals.snapshotAge * 1000.0 / frames};
+    simulationTotals = {};
+
     glfwSetWindowTitle(
         window,
-        std::string{title + std::format(" [{:.2f} fps]", framerate)}.c_str());
+        std::string{title +
+                    std::format(" [{:.2f} fps] [binds/frame: {} issued, {} "
+                                "elided] [objects/frame: {} visible, {} "
+                                "culled, {} demoted, {} dropped] [sphere "
+                                "cull: {:.3f} ms/frame cpu] [sim: {:.3f} "
+                                "ms/tick, {:.1f} ms old]",
+                                framerate, issued, elided, visible, culled,
+                                demoted, dropped, sphereCullMs, tickMs,
+                                snapshotAgeMs)}
+            .c_str());
     frameCount = 0;
   }
 };
+
+// Sums the per-view culling results of a frame into the totals shown in the
+// title.
+void FpsCounter::addCullStats(std::span<const CullStats> stats) {
+  for (const auto& view : stats) {
+    cullTotals.visible += view.visible;
+    cullTotals.culled += view.culled;
+  }
+}
+
+void FpsCounter::addLodStats(const LodStats& stats) {
+  lodTotals.demoted += stats.demoted;
+  lodTotals.dropped += stats.dropped;
+}
+
+void FpsCounter::addSphereCullTime(const double& seconds) {
+  sphereCullTotal += seconds;
+}
+
+// Summed per frame and averaged in the title. The tick time is that of the
+// latest tick when the simulation runs on its own thread, so it is sampled
+// rather than summed over every tick.
+void FpsCounter::addSimulationStats(const SimulationStats& stats) {
+  simulationTotals.tickSeconds += stats.tickSeconds;
+  simulationTotals.snapshotAge += stats.snapshotAge;
+}
@@ -1,16 +1,32 @@
 #pragma once
+#include <algorithm>
 #include <format>
 #include <GLFW/glfw3.h>
+#include <span>
 #include <string>
 
+#include "frustum.h"
+#include "render_queue.h"
+#include "render_state.h"
+#include "simulation.h"
+
 class FpsCounter {
 public:
   FpsCounter(GLFWwindow* window, const char* title, double initTimestamp);
   void updateFramerate(double currentTimestamp);
+  void addCullStats(std::span<const CullStats> stats);
+  void addLodStats(const LodStats& stats);
+  void addSphereCullTime(const double& seconds);
+  void addSimulationStats(const SimulationStats& stats);
 
 private:
   GLFWwindow* window{};
   std::string title{};
   double referenceTimestamp{};
   int frameCount{};
+  RenderStateCounters lastCounters{};
+  CullStats cullTotals{};
+  LodStats lodTotals{};
+  double sphereCullTotal{};
+  SimulationStats simulationTotals{};
 };
@@ -0,0 +1,65 @@
+#include "frustum.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2
+#endif
+
+// Gribb and Hartmann: each plane is the last row of the matrix plus or minus
+// one of the others.
+Frustum::Frustum(const glm::mat4& viewProjection) {
+  const auto row{[&](const int& i) {
+    return glm::vec4{viewProjection[0][i], viewProjection[1][i],
+                     viewProjection[2][i], viewProjection[3][i]};
+  }};
+
+  _planes = {row(3) + row(0), row(3) - row(0), row(3) + row(1),
+            row(3) - row(1), row(3) + row(2), row(3) - row(2)};
+  for (auto& plane : _planes) plane /= glm::length(glm::vec3{plane});
+}
+
+bool Frustum::intersects(const BoundingSphere& bounds) const noexcept {
+  for (const auto& plane : _planes)
+    if (glm::dot(glm::vec3{plane}, glm::vec3{bounds}) + plane.w < -bounds.w)
+      return false;
+  return true;
+}
+
+const std::array<glm::vec4, 6>& Frustum::planes() const noexcept {
+  return _planes;
+}
+
+// Writes 1 for every sphere touching the frustum and 0 for the rest. Four
+// spheres are transposed into SSE registers and tested against a plane at a
+// time; whatever does not fill a register goes through the scalar test.
+void Frustum::intersects(std::span<const BoundingSphere> bounds,
+                         std::span<uint8_t> visible) const noexcept {
+  size_t i{0};
+
+#ifdef FRUSTUM_SSE2
+  for (; i + 4 <= bounds.size(); i += 4) {
+    const auto data{reinterpret_cast<const float*>(bounds.data() + i)};
+    auto x{_mm_loadu_ps(data)};
+    auto y{_mm_loadu_ps(data + 4)};
+    auto z{_mm_loadu_ps(data + 8)};
+    auto radius{_mm_loadu_ps(data + 12)};
+    _MM_TRANSPOSE4_PS(x, y, z, radius);
+
+    const auto negativeRadius{_mm_sub_ps(_mm_setzero_ps(), radius)};
+    auto inside{_mm_castsi128_ps(_mm_set1_epi32(-1))};
+    for (const auto& plane : _planes) {
+      auto distance{_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)),
+                               _mm_mul_ps(y, _mm_set1_ps(plane.y)))};
+      distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+      distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+    }
+
+    const auto mask{_mm_movemask_ps(inside)};
+    for (size_t j = 0; j < 4; j++) visible[i + j] = (mask >> j) & 1;
+  }
+#endif
+
+  for (; i < bounds.size(); i++) visible[i] = intersects(bounds[i]);
+}
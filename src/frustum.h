@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// A bounding sphere packed as the center in xyz and the radius in w, the same
+// layout the sphere instance buffer uses.
+using BoundingSphere = glm::vec4;
+
+// Objects of one view that passed and failed the frustum test.
+struct CullStats {
+  uint32_t visible;
+  uint32_t culled;
+};
+
+// The six clip planes of a view-projection matrix, pointing inwards and
+// normalized so a plane's value at a point is its signed distance.
+class Frustum {
+public:
+  Frustum() = default;
+  explicit Frustum(const glm::mat4& viewProjection);
+  bool intersects(const BoundingSphere& bounds) const noexcept;
+  void intersects(std::span<const BoundingSphere> bounds,
+                  std::span<uint8_t> visible) const noexcept;
+  const std::array<glm::vec4, 6>& planes() const noexcept;
+
+private:
+  std::array<glm::vec4, 6> _planes{};
+};
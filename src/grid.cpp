@@ -3,7 +3,7 @@
 const GLuint& GridVaoProvider::vao() const {
   static auto _ = std::invoke([this] {
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    RenderState::bindVertexArray(_vao);
 
     GLuint vbo{};
     glGenBuffers(1, &vbo);
@@ -38,22 +38,18 @@ const GLuint& GridVaoProvider::vao() const {
 };
 
 GridComponent::GridComponent() {
-  auto model{glm::mat4(1.0)};
   model = glm::scale(model, glm::vec3{2.0});
   model = glm::rotate(model, glm::radians(90.0f), glm::vec3{1.0, 0.0, 0.0});
-
-  setUniformToProgram(shaderProgramProvider.program(), "model", model);
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{0.6f});
 };
 
-void GridComponent::render(const glm::mat4& view, const glm::mat4& proj) const {
-  glBindVertexArray(vaoProvider.vao());
-  glUseProgram(shaderProgramProvider.program());
-  setUniformToProgram(shaderProgramProvider.program(), "view", view);
-  setUniformToProgram(shaderProgramProvider.program(), "proj", proj);
+void GridComponent::enqueue(RenderQueue& queue) const {
+  if (!queue.isVisible(bounds)) return;
 
-  glDrawArrays(GL_LINES, 0, (vaoProvider.gridCount + 1) * 2);
-  glDrawArrays(GL_LINES, (vaoProvider.gridCount + 1) * 2,
-               (vaoProvider.gridCount + 1) * 2);
+  queue.push({.program{queue.programOf(shaderProgramProvider)},
+              .vao{vaoProvider.vao()},
+              .primitive{GL_LINES},
+              .count{(vaoProvider.gridCount + 1) * 4},
+              .instanceCount{queue.viewCount()},
+              .model{model},
+              .color{glm::vec4{0.6f}}});
 };
@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "render_queue.h"
 #include "shader.h"
 
 class GridVaoProvider {
@@ -18,9 +19,12 @@ private:
 class GridComponent {
 public:
   GridComponent();
-  void render(const glm::mat4& view, const glm::mat4& proj) const;
+  void enqueue(RenderQueue& queue) const;
 
 private:
+  glm::mat4 model{1.0};
   static inline const BasicShaderProgramProvider shaderProgramProvider{};
   static inline const GridVaoProvider vaoProvider{};
+  // The unit grid scaled to 2 x 2 around the origin.
+  static inline const BoundingSphere bounds{0.0f, 0.0f, 0.0f, 1.4143f};
 };
@@ -1,7 +1,11 @@
 #include <algorithm>
 #include <array>
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <optional>
 #include <random>
+#include <string>
 #include <vector>
 
 #include <glad/glad.h>
@@ -11,21 +15,68 @@
 
 #include "fps_counter.h"
 #include "global_timer.h"
+#include "multi_view.h"
 #include "quad_tree.h"
 #include "raii_glfw.h"
 #include "scene.h"
+#include "simulation.h"
 #include "user_control.h"
+#include "view_layout.h"
 
-const float viewAspectRatio(const int& width, const int& height);
 void keyCallback(GLFWwindow* window, int key, int scancode, int action,
                  int mods) noexcept;
+void windowSizeCallback(GLFWwindow* window, int width, int height) noexcept;
+void framebufferSizeCallback(GLFWwindow* window, int width,
+                             int height) noexcept;
+
+// Everything the generated scene depends on, so a run can be repeated, or
+// the scene file to load instead. With an output file, the scene is written
+// there rather than shown.
+struct SceneOptions {
+  uint64_t seed;
+  size_t sphereCount;
+  std::string sceneFile;
+  std::string outputFile;
+};
+std::optional<SceneOptions> parseSceneOptions(int argc, char* argv[]);
 
 struct WindowUserData {
-  std::vector<std::shared_ptr<QuadTreeNode>> quadTree;
+  QuadTree quadTree;
+  uint32_t focusedNode;
   bool isBirdView;
+  bool isSharedViewMode;
+  bool isMultiViewMode;
+  LodSettings lodSettings;
+  SphereRenderMode sphereRenderMode;
+  SphereCullMode sphereCullMode;
+  SphereAnimationMode sphereAnimationMode;
+  bool isSimulationThreaded;
+  int windowWidth;
+  int windowHeight;
+  int framebufferWidth;
+  int framebufferHeight;
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+  const auto sceneOptions{parseSceneOptions(argc, argv)};
+  if (!sceneOptions) {
+    std::cout << "Usage: " << argv[0]
+              << " [--seed N] [--spheres N] [--scene FILE]"
+                 " [--write-scene FILE]"
+              << std::endl;
+    return -1;
+  }
+  if (!sceneOptions->outputFile.empty()) {
+    SphereStore spheres{};
+    generateSpheres(spheres, sceneOptions->seed, sceneOptions->sphereCount);
+    writeSceneFile(sceneOptions->outputFile, sceneOptions->seed,
+                   defaultStaticLayout(), spheres);
+    std::cout << "Scene seed " << sceneOptions->seed << ", "
+              << sceneOptions->sphereCount << " spheres written to "
+              << sceneOptions->outputFile << std::endl;
+    return 0;
+  }
+
   const RaiiGlfw raiiGlfw{};
 
   constexpr int defaultWidth{720};
@@ -48,63 +99,181 @@ int main() {
   glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
   glEnable(GL_DEPTH_TEST);
 
-  SceneController sceneController{};
-
-  WindowUserData userData{.quadTree{std::make_shared<QuadTreeNode>(
-                              1.0f, 1.0f, 0.0f, 0.0f,
-                              std::make_shared<FirstPersonController>(
-                                  window, glm::vec3{0.0f, 0.2f, 0.8f}))},
-                          .isBirdView{false}};
-
-  Scene scene{viewAspectRatio(defaultWidth, defaultHeight)};
+  // A scene file is only read while the scene is built; the spheres are
+  // copied out and the static meshes uploaded.
+  const auto loadStart{glfwGetTime()};
+  std::optional<SceneFile> sceneFile{};
+  if (!sceneOptions->sceneFile.empty())
+    sceneFile.emplace(sceneOptions->sceneFile);
+  const auto seed{sceneFile ? sceneFile->seed() : sceneOptions->seed};
+  SceneController sceneController{
+      sceneFile ? SceneController{*sceneFile}
+                : SceneController{seed, sceneOptions->sphereCount}};
+  Scene scene{sceneFile ? sceneFile->layout() : defaultStaticLayout()};
+  if (sceneFile)
+    std::cout << "Scene file " << sceneOptions->sceneFile << " loaded in "
+              << (glfwGetTime() - loadStart) * 1000.0 << " ms" << std::endl;
+  sceneFile.reset();
+  std::cout << "Scene seed " << seed << ", "
+            << sceneController.sceneData().spheres.size() << " spheres"
+            << std::endl;
+
+  WindowUserData userData{
+      .quadTree{QuadTree{glm::vec3{0.0f, 0.2f, 0.8f}, seed}},
+      .focusedNode{0},
+      .isBirdView{false},
+      .isSharedViewMode{true},
+      .isMultiViewMode{false},
+      .lodSettings{},
+      .sphereRenderMode{SphereRenderMode::Mesh},
+      .sphereCullMode{SphereCullMode::Cpu},
+      .sphereAnimationMode{SphereAnimationMode::Cpu},
+      .isSimulationThreaded{false}};
+  glfwGetWindowSize(window, &userData.windowWidth, &userData.windowHeight);
+  glfwGetFramebufferSize(window, &userData.framebufferWidth,
+                         &userData.framebufferHeight);
+
+  ViewLayout viewLayout{};
+  CameraUniformBuffer cameraUniforms{};
+  MultiViewRenderer multiViewRenderer{};
 
   glfwSetWindowUserPointer(window, &userData);
 
   glfwSetKeyCallback(window, keyCallback);
+  glfwSetWindowSizeCallback(window, windowSizeCallback);
+  glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 
   GlobalTimer globalTimer{};
 
   FpsCounter fpsCounter{window, windowTitle, globalTimer.getCurrentTime()};
 
+  // While running, the simulation thread owns sceneController and each frame
+  // draws a copy interpolated from its snapshots.
+  std::optional<SimulationThread> simulation{};
+  SceneData interpolatedData{};
+
+  double lastCursorX{}, lastCursorY{};
+  glfwGetCursorPos(window, &lastCursorX, &lastCursorY);
+
   while (!glfwWindowShouldClose(window)) {
 
     globalTimer.updateTime();
 
     fpsCounter.updateFramerate(globalTimer.getCurrentTime());
 
-    sceneController.updateSceneData(userData.isBirdView,
-                                    globalTimer.getCurrentTime());
+    if (userData.isSimulationThreaded != simulation.has_value()) {
+      if (simulation)
+        simulation.reset();
+      else
+        simulation.emplace(sceneController, 1.0 / 60.0,
+                           globalTimer.getCurrentTime());
+    }
+
+    scene.setSphereAnimationMode(userData.sphereAnimationMode);
+    if (simulation) {
+      simulation->setAnimationMode(userData.sphereAnimationMode);
+      simulation->interpolate(interpolatedData, globalTimer.getCurrentTime());
+      interpolatedData.isBirdView = userData.isBirdView;
+      fpsCounter.addSimulationStats(
+          simulation->stats(globalTimer.getCurrentTime()));
+    } else {
+      const auto tickStart{glfwGetTime()};
+      sceneController.setAnimationMode(userData.sphereAnimationMode);
+      sceneController.updateSceneData(userData.isBirdView,
+                                      globalTimer.getCurrentTime());
+      fpsCounter.addSimulationStats(
+          {.tickSeconds{glfwGetTime() - tickStart}, .snapshotAge{0.0}});
+    }
+    const auto& sceneData{simulation ? interpolatedData
+                                     : sceneController.sceneData()};
+    scene.update(sceneData);
+    scene.setLodSettings(userData.lodSettings);
+    scene.setSphereRenderMode(userData.sphereRenderMode);
+    scene.setSphereCullMode(userData.sphereCullMode);
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    int windowWidth{}, windowHeight{};
-    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    double cursorX{}, cursorY{};
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+
+    // The hovered view takes focus, and only the focused view turns with the
+    // mouse, so a single camera is recomputed per frame at most.
+    const auto pointX{static_cast<float>(cursorX / userData.windowWidth)};
+    const auto pointY{1.0f -
+                      static_cast<float>(cursorY / userData.windowHeight)};
+    if (!userData.isBirdView && pointX >= 0.0f && pointX < 1.0f &&
+        pointY >= 0.0f && pointY < 1.0f) {
+      const auto hoveredNode{userData.quadTree.leafAt(pointX, pointY)};
+      if (hoveredNode == userData.focusedNode &&
+          (cursorX != lastCursorX || cursorY != lastCursorY))
+        userData.quadTree
+            .controller(userData.quadTree.controllerIdxOf(hoveredNode))
+            .look(cursorX - lastCursorX, cursorY - lastCursorY);
+      userData.focusedNode = hoveredNode;
+    }
+    lastCursorX = cursorX;
+    lastCursorY = cursorY;
+
+    viewLayout.update(userData.quadTree, userData.framebufferWidth,
+                      userData.framebufferHeight);
 
     if (userData.isBirdView) {
-      glViewport(0, 0, windowWidth, windowHeight);
-      scene.updateViewAspectRatio(viewAspectRatio(windowWidth, windowHeight));
-      scene.render(glm::lookAt({1.25, 4, 1.25}, glm::vec3{0}, {0, 1, 0}),
-                   sceneController.sceneData(), glm::vec3{1.5, 1.5, 1.5},
-                   getQuadTreeLeaves(userData.quadTree));
+      const auto& rect{viewLayout.windowRect()};
+      glViewport(rect.x, rect.y, rect.width, rect.height);
+      cameraUniforms.setView(
+          0, glm::lookAt({1.25, 4, 1.25}, glm::vec3{0}, {0, 1, 0}),
+          viewLayout.windowProjection(), glm::vec3{1.5, 1.5, 1.5},
+          rect.height);
+      cameraUniforms.upload(1);
+      scene.render(cameraUniforms, sceneData, userData.quadTree);
 
     } else {
-      for (auto& leaf : getQuadTreeLeaves(userData.quadTree)) {
-        leaf->firstPersonController->updateView();
-
-        glViewport(static_cast<GLint>(leaf->x * windowWidth),
-                   static_cast<GLint>(leaf->y * windowHeight),
-                   static_cast<GLsizei>(leaf->width * windowWidth),
-                   static_cast<GLsizei>(leaf->height * windowHeight));
-        scene.updateViewAspectRatio(
-            viewAspectRatio(static_cast<int>(leaf->width * windowWidth),
-                            static_cast<int>(leaf->height * windowHeight)));
-        scene.render(leaf->firstPersonController->view(),
-                     sceneController.sceneData(),
-                     leaf->firstPersonController->position(),
-                     getQuadTreeLeaves(userData.quadTree));
+      const auto leaves{userData.quadTree.leaves()};
+      const auto rects{viewLayout.rects()};
+      const auto projections{viewLayout.projections()};
+      const auto renderedLeaves{userData.isSharedViewMode
+                                    ? viewLayout.sourceLeaves()
+                                    : viewLayout.allLeaves()};
+
+      if (userData.isMultiViewMode) {
+        for (size_t offset = 0; offset < renderedLeaves.size();
+             offset += MultiViewRenderer::maxViews) {
+          const auto viewCount{multiViewRenderer.prepare(
+              userData.quadTree, viewLayout, renderedLeaves.subspan(offset),
+              cameraUniforms)};
+          scene.renderViews(cameraUniforms, viewCount);
+        }
+      } else {
+        for (const auto& i : renderedLeaves) {
+          const auto& controller{
+              userData.quadTree.controller(leaves.controllerIdx[i])};
+
+          glViewport(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+          cameraUniforms.setView(0, controller.view(), projections[i],
+                                 controller.position(), rects[i].height);
+          cameraUniforms.upload(1);
+          scene.render(cameraUniforms, sceneData, userData.quadTree);
+        }
+      }
+
+      if (userData.isSharedViewMode) {
+        // The source and target rects never overlap, so the back buffer can
+        // be both the read and the draw side of the blit.
+        for (const auto& [sourceLeaf, targetLeaf] : viewLayout.sharedViews()) {
+          const auto& source{rects[sourceLeaf]};
+          const auto& target{rects[targetLeaf]};
+          glBlitFramebuffer(source.x, source.y, source.x + source.width,
+                            source.y + source.height, target.x, target.y,
+                            target.x + target.width, target.y + target.height,
+                            GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        }
       }
     }
 
+    fpsCounter.addCullStats(scene.cullStats());
+    fpsCounter.addLodStats(scene.lodStats());
+    fpsCounter.addSphereCullTime(scene.sphereCullTime());
+
     glfwSwapBuffers(window);
     glfwPollEvents();
   }
@@ -112,9 +281,33 @@ int main() {
   return 0;
 }
 
-const float viewAspectRatio(const int& width, const int& height) {
-  if (height == 0) throw std::runtime_error("height is 0");
-  return static_cast<float>(width) / height;
+
+// Without --seed, the scene is seeded at random; the seed is printed either
+// way so the run can be repeated. A scene file brings its own seed.
+std::optional<SceneOptions> parseSceneOptions(int argc, char* argv[]) {
+  SceneOptions options{.seed{std::random_device{}()}, .sphereCount{100}};
+  options.seed = options.seed << 32 | std::random_device{}();
+
+  for (int i = 1; i < argc; i++) {
+    const auto isSeed{std::strcmp(argv[i], "--seed") == 0};
+    const auto isSpheres{std::strcmp(argv[i], "--spheres") == 0};
+    const auto isScene{std::strcmp(argv[i], "--scene") == 0};
+    const auto isOutput{std::strcmp(argv[i], "--write-scene") == 0};
+    if ((!isSeed && !isSpheres && !isScene && !isOutput) || i + 1 == argc)
+      return {};
+
+    const auto value{argv[++i]};
+    if (isScene || isOutput) {
+      (isScene ? options.sceneFile : options.outputFile) = value;
+      continue;
+    }
+    const auto end{value + std::strlen(value)};
+    const auto [parsed, error]{
+        isSeed ? std::from_chars(value, end, options.seed)
+               : std::from_chars(value, end, options.sphereCount)};
+    if (error != std::errc{} || parsed != end) return {};
+  }
+  return options;
 }
 
 void keyCallback(GLFWwindow* window, int key, int scancode, int action,
@@ -125,16 +318,116 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action,
   WindowUserData* userData =
       static_cast<WindowUserData*>(glfwGetWindowUserPointer(window));
 
-  if (key == GLFW_KEY_UP && action == GLFW_PRESS) {
-    growQuadTree(userData->quadTree, window, true);
-    growQuadTree(userData->quadTree, window, false);
-  }
+  auto& quadTree{userData->quadTree};
+  auto& focusedNode{userData->focusedNode};
+
+  if (key == GLFW_KEY_UP && action == GLFW_PRESS)
+    focusedNode = quadTree.splitAlongLongerSide(focusedNode);
+
+  if (key == GLFW_KEY_H && action == GLFW_PRESS)
+    focusedNode = quadTree.split(focusedNode, SplitLayout::SideBySide);
+
+  if (key == GLFW_KEY_V && action == GLFW_PRESS)
+    focusedNode = quadTree.split(focusedNode, SplitLayout::Stacked);
 
-  if (key == GLFW_KEY_DOWN && action == GLFW_PRESS) {
-    shrinkQuadTree(userData->quadTree);
-    shrinkQuadTree(userData->quadTree);
+  if (key == GLFW_KEY_Q && action == GLFW_PRESS)
+    focusedNode = quadTree.split(focusedNode, SplitLayout::Quad);
+
+  if (key == GLFW_KEY_DOWN && action == GLFW_PRESS &&
+      quadTree.parent(focusedNode) != QuadTree::nullNode) {
+    focusedNode = quadTree.parent(focusedNode);
+    quadTree.merge(focusedNode);
   }
 
   if (key == GLFW_KEY_TAB && action == GLFW_PRESS)
     userData->isBirdView = !userData->isBirdView;
+
+  if (key == GLFW_KEY_B && action == GLFW_PRESS)
+    userData->isSharedViewMode = !userData->isSharedViewMode;
+
+  if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+    if (MultiViewRenderer::isSupported())
+      userData->isMultiViewMode = !userData->isMultiViewMode;
+    else
+      std::cout << "Multi-view rendering needs OpenGL 4.1 and "
+                   "GL_ARB_shader_viewport_layer_array"
+                << std::endl;
+  }
+
+  if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+    const auto isImpostor{userData->sphereRenderMode ==
+                          SphereRenderMode::Impostor};
+    userData->sphereRenderMode =
+        isImpostor ? SphereRenderMode::Mesh : SphereRenderMode::Impostor;
+    std::cout << "Spheres drawn as " << (isImpostor ? "meshes" : "impostors")
+              << std::endl;
+  }
+
+  if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+    if (SphereComponent::isGpuCullSupported()) {
+      const auto isGpu{userData->sphereCullMode == SphereCullMode::Gpu};
+      userData->sphereCullMode =
+          isGpu ? SphereCullMode::Cpu : SphereCullMode::Gpu;
+      std::cout << "Spheres culled on the " << (isGpu ? "CPU" : "GPU")
+                << std::endl;
+    } else
+      std::cout << "GPU culling needs OpenGL 4.3" << std::endl;
+  }
+
+  if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+    const auto isShader{userData->sphereAnimationMode ==
+                        SphereAnimationMode::Shader};
+    userData->sphereAnimationMode =
+        isShader ? SphereAnimationMode::Cpu : SphereAnimationMode::Shader;
+    std::cout << "Sphere orbits evaluated on the "
+              << (isShader ? "CPU" : "GPU") << std::endl;
+  }
+
+  if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+    userData->isSimulationThreaded = !userData->isSimulationThreaded;
+    std::cout << "Scene simulated "
+              << (userData->isSimulationThreaded ? "on its own thread"
+                                                 : "once per frame")
+              << std::endl;
+  }
+
+  if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+    const auto isPhysics{userData->sphereAnimationMode ==
+                         SphereAnimationMode::Physics};
+    userData->sphereAnimationMode =
+        isPhysics ? SphereAnimationMode::Cpu : SphereAnimationMode::Physics;
+    std::cout << (isPhysics ? "Spheres back on their orbits"
+                            : "Spheres bouncing off each other")
+              << std::endl;
+  }
+
+  // Objects under the drop radius are skipped; the bias scales the radius
+  // every sphere level switches at.
+  auto& lodSettings{userData->lodSettings};
+  if ((key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET ||
+       key == GLFW_KEY_MINUS || key == GLFW_KEY_EQUAL) &&
+      action == GLFW_PRESS) {
+    if (key == GLFW_KEY_LEFT_BRACKET)
+      lodSettings.dropRadius = std::max(lodSettings.dropRadius - 0.5f, 0.0f);
+    if (key == GLFW_KEY_RIGHT_BRACKET) lodSettings.dropRadius += 0.5f;
+    if (key == GLFW_KEY_MINUS) lodSettings.lodBias /= 1.25f;
+    if (key == GLFW_KEY_EQUAL) lodSettings.lodBias *= 1.25f;
+    std::cout << "LOD drop radius " << lodSettings.dropRadius
+              << " px, bias " << lodSettings.lodBias << std::endl;
+  }
+}
+
+void windowSizeCallback(GLFWwindow* window, int width, int height) noexcept {
+  WindowUserData* userData =
+      static_cast<WindowUserData*>(glfwGetWindowUserPointer(window));
+  userData->windowWidth = width;
+  userData->windowHeight = height;
+}
+
+void framebufferSizeCallback(GLFWwindow* window, int width,
+                             int height) noexcept {
+  WindowUserData* userData =
+      static_cast<WindowUserData*>(glfwGetWindowUserPointer(window));
+  userData->framebufferWidth = width;
+  userData->framebufferHeight = height;
 }
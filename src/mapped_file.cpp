@@ -0,0 +1,66 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& fileName) {
+  file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("No such file: " + fileName);
+
+  LARGE_INTEGER fileSize{};
+  GetFileSizeEx(file, &fileSize);
+  size = static_cast<size_t>(fileSize.QuadPart);
+  if (size > 0)
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping)
+    data = static_cast<const std::byte*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!data) {
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    throw std::runtime_error("Fail to map file: " + fileName);
+  }
+}
+
+MappedFile::~MappedFile() {
+  UnmapViewOfFile(data);
+  CloseHandle(mapping);
+  CloseHandle(file);
+}
+#else
+// The descriptor is closed right away; the mapping keeps the file open.
+MappedFile::MappedFile(const std::string& fileName) {
+  const auto descriptor{open(fileName.c_str(), O_RDONLY)};
+  if (descriptor < 0) throw std::runtime_error("No such file: " + fileName);
+
+  struct stat status {};
+  void* address{MAP_FAILED};
+  if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+    size = static_cast<size_t>(status.st_size);
+    address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  }
+  close(descriptor);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("Fail to map file: " + fileName);
+  data = static_cast<const std::byte*>(address);
+}
+
+MappedFile::~MappedFile() {
+  munmap(const_cast<std::byte*>(data), size);
+}
+#endif
+
+std::span<const std::byte> MappedFile::bytes() const noexcept {
+  return {data, size};
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// A whole file mapped read-only into memory, so reading it takes no copy
+// into a buffer first and pages come in as they are touched.
+class MappedFile {
+public:
+  MappedFile(const std::string& fileName);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+  std::span<const std::byte> bytes() const noexcept;
+
+private:
+  const std::byte* data{};
+  size_t size{};
+#ifdef _WIN32
+  void* file{};
+  void* mapping{};
+#endif
+};
@@ -0,0 +1,35 @@
+#include "multi_view.h"
+
+bool MultiViewRenderer::isSupported() {
+  static const bool supported{
+      GLAD_GL_VERSION_4_1 &&
+      glfwExtensionSupported("GL_ARB_shader_viewport_layer_array")};
+  return supported;
+}
+
+GLsizei MultiViewRenderer::prepare(const QuadTree& quadTree,
+                                   const ViewLayout& viewLayout,
+                                   std::span<const uint32_t> leaves,
+                                   CameraUniformBuffer& cameraUniforms) {
+  const auto viewCount{std::min(leaves.size(), maxViews)};
+  const auto allLeaves{quadTree.leaves()};
+  const auto rects{viewLayout.rects()};
+  const auto projections{viewLayout.projections()};
+
+  for (size_t i = 0; i < viewCount; i++) {
+    const auto leaf{leaves[i]};
+    const auto& controller{quadTree.controller(allLeaves.controllerIdx[leaf])};
+    cameraUniforms.setView(i, controller.view(), projections[leaf],
+                           controller.position(), rects[leaf].height);
+
+    viewports[i * 4 + 0] = static_cast<GLfloat>(rects[leaf].x);
+    viewports[i * 4 + 1] = static_cast<GLfloat>(rects[leaf].y);
+    viewports[i * 4 + 2] = static_cast<GLfloat>(rects[leaf].width);
+    viewports[i * 4 + 3] = static_cast<GLfloat>(rects[leaf].height);
+  }
+
+  glViewportArrayv(0, static_cast<GLsizei>(viewCount), viewports.data());
+  cameraUniforms.upload(static_cast<GLsizei>(viewCount));
+
+  return static_cast<GLsizei>(viewCount);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "quad_tree.h"
+#include "uniform_blocks.h"
+#include "view_layout.h"
+
+// Draws up to maxViews leaves in one submission. Each leaf gets a slot in
+// the viewport array and in the Camera block, and the multi-view shader
+// variants route instance i to viewport i through gl_ViewportIndex.
+class MultiViewRenderer {
+public:
+  static constexpr size_t maxViews{CameraUniformBuffer::maxViews};
+  static bool isSupported();
+  GLsizei prepare(const QuadTree& quadTree, const ViewLayout& viewLayout,
+                  std::span<const uint32_t> leaves,
+                  CameraUniformBuffer& cameraUniforms);
+
+private:
+  std::array<GLfloat, maxViews * 4> viewports{};
+};
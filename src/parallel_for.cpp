@@ -0,0 +1,65 @@
+#include "parallel_for.h"
+
+// Set while a thread runs a job, so a parallelFor inside the job does not
+// wait for the pool it is already part of.
+static thread_local bool isInJob{};
+
+WorkerPool::WorkerPool(const size_t& workerCount) {
+  for (size_t i = 0; i < workerCount; i++)
+    workers.emplace_back([this] { work(); });
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    const std::lock_guard lock{mutex};
+    isStopping = true;
+  }
+  jobReady.notify_all();
+  workers.clear();
+}
+
+// One worker per hardware thread besides the caller's, started on first use.
+WorkerPool& WorkerPool::shared() {
+  static WorkerPool pool{std::max(std::thread::hardware_concurrency(), 1u) -
+                         1};
+  return pool;
+}
+
+// The job stays in place until every worker has reported back, so workers
+// read it without holding the lock.
+void WorkerPool::dispatch(void (*_task)(const void*), const void* _context) {
+  std::unique_lock job{jobMutex, std::defer_lock};
+  if (!isInJob) job.try_lock();
+  if (!job.owns_lock() || workers.empty()) return _task(_context);
+
+  {
+    const std::lock_guard lock{mutex};
+    task = _task;
+    context = _context;
+    generation++;
+    running = workers.size();
+  }
+  jobReady.notify_all();
+  isInJob = true;
+  _task(_context);
+  isInJob = false;
+
+  std::unique_lock lock{mutex};
+  jobDone.wait(lock, [this] { return running == 0; });
+}
+
+void WorkerPool::work() {
+  isInJob = true;
+  uint64_t done{};
+  std::unique_lock lock{mutex};
+  while (true) {
+    jobReady.wait(lock, [&] { return isStopping || generation != done; });
+    if (isStopping) return;
+    done = generation;
+
+    lock.unlock();
+    task(context);
+    lock.lock();
+    if (--running == 0) jobDone.notify_one();
+  }
+}
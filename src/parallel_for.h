@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads started once and handed one job at a time, which every one of them
+// and the calling thread run together. A call made while the pool is busy
+// with another caller's job, or from inside a job, runs the job on the
+// calling thread alone instead of waiting.
+class WorkerPool {
+public:
+  explicit WorkerPool(const size_t& workerCount);
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  ~WorkerPool();
+  static WorkerPool& shared();
+
+  template <typename Task> void run(const Task& task) {
+    dispatch([](const void* task) { (*static_cast<const Task*>(task))(); },
+             &task);
+  }
+
+private:
+  std::mutex jobMutex{};
+  std::mutex mutex{};
+  std::condition_variable jobReady{};
+  std::condition_variable jobDone{};
+  void (*task)(const void*){};
+  const void* context{};
+  uint64_t generation{};
+  size_t running{};
+  bool isStopping{};
+  std::vector<std::jthread> workers{};
+
+  void dispatch(void (*_task)(const void*), const void* _context);
+  void work();
+};
+
+// Calls body(first, last) for every chunk of chunkSize items in [0, count),
+// spread over the shared pool with the calling thread taking chunks as well.
+// The chunks depend on count and chunkSize alone, so a body that only writes
+// its own range gives the same result on any number of threads. A single
+// chunk runs inline without waking the pool.
+template <typename Body>
+void parallelFor(const size_t& count, const size_t& chunkSize,
+                 const Body& body) {
+  const auto chunkCount{(count + chunkSize - 1) / chunkSize};
+  std::atomic<size_t> nextChunk{0};
+  const auto run{[&] {
+    for (auto chunk{nextChunk++}; chunk < chunkCount; chunk = nextChunk++)
+      body(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+  }};
+
+  if (chunkCount <= 1) return run();
+  WorkerPool::shared().run(run);
+}
@@ -1,74 +1,218 @@
 #include "quad_tree.h"
 
-static const size_t getParentIdx(const size_t& idx) noexcept;
-static const size_t getDepth(const size_t& idx) noexcept;
-static const glm::vec3 generateRandomPosition() noexcept;
-
-std::vector<std::shared_ptr<QuadTreeNode>>
-getQuadTreeLeaves(std::vector<std::shared_ptr<QuadTreeNode>>& tree) {
-  std::vector<std::shared_ptr<QuadTreeNode>> leaves{};
-  for (size_t i = tree.size() / 2; i < tree.size(); i++) {
-    leaves.push_back(tree.at(i));
-  }
+QuadTree::QuadTree(const glm::vec3& rootPosition, const uint64_t& seed)
+    : seed{seed} {
+  controllers.emplace_back(rootPosition);
+  controllerRefCount.push_back(0);
+  insertLeaf(allocateNode(1.0f, 1.0f, 0.0f, 0.0f, 0, nullNode));
+}
 
-  return leaves;
-};
+QuadTreeLeaves QuadTree::leaves() const noexcept {
+  return {.x{leafX},
+          .y{leafY},
+          .width{leafWidth},
+          .height{leafHeight},
+          .controllerIdx{leafControllerIdx},
+          .node{leafNode}};
+}
+
+FirstPersonController& QuadTree::controller(const uint32_t& idx) {
+  return controllers[idx];
+}
 
-void shrinkQuadTree(std::vector<std::shared_ptr<QuadTreeNode>>& tree) {
-  if (tree.size() > 1) tree.pop_back();
+const FirstPersonController& QuadTree::controller(const uint32_t& idx) const {
+  return controllers[idx];
 }
 
-void growQuadTree(std::vector<std::shared_ptr<QuadTreeNode>>& tree,
-                  GLFWwindow* window, bool inheritParentController) {
-  if (tree.empty()) return;
+uint64_t QuadTree::version() const noexcept { return _version; }
 
-  const auto newIdx = tree.size();
-  const auto& parent = tree[getParentIdx(newIdx)];
+uint32_t QuadTree::root() const noexcept { return 0; }
 
-  std::shared_ptr<FirstPersonController> controller(nullptr);
+uint32_t QuadTree::parent(const uint32_t& node) const noexcept {
+  return parentIdx[node];
+}
 
-  if (inheritParentController)
-    controller = std::make_shared<FirstPersonController>(
-        window, generateRandomPosition());
-  else controller = parent->firstPersonController;
+bool QuadTree::isLeaf(const uint32_t& node) const noexcept {
+  return childCount[node] == 0;
+}
 
-  if (getDepth(newIdx) % 2 != 0) {
-    if (newIdx % 2 != 0) {
-      tree.push_back(std::make_shared<QuadTreeNode>(
-          parent->width / 2, parent->height, parent->x, parent->y, controller));
-    } else {
-      tree.push_back(std::make_shared<QuadTreeNode>(
-          parent->width / 2, parent->height, parent->x + parent->width / 2,
-          parent->y, controller));
-    }
-  } else {
-    if (newIdx % 2 != 0) {
-      tree.push_back(std::make_shared<QuadTreeNode>(
-          parent->width, parent->height / 2, parent->x, parent->y, controller));
-    } else {
-      tree.push_back(std::make_shared<QuadTreeNode>(
-          parent->width, parent->height / 2, parent->x,
-          parent->y + parent->height / 2, controller));
+// Descends from the root through the child whose rect contains the point,
+// so the lookup costs O(depth) rather than a scan over every leaf. The point
+// is in normalized window coordinates with the origin at the bottom left.
+uint32_t QuadTree::leafAt(const float& pointX,
+                          const float& pointY) const noexcept {
+  auto node{root()};
+  while (!isLeaf(node)) {
+    auto next{children[node][0]};
+    for (size_t i = 0; i < childCount[node]; i++) {
+      const auto child{children[node][i]};
+      if (pointX >= x[child] && pointX < x[child] + width[child] &&
+          pointY >= y[child] && pointY < y[child] + height[child]) {
+        next = child;
+        break;
+      }
     }
+    node = next;
+  }
+  return node;
+}
+
+uint32_t QuadTree::controllerIdxOf(const uint32_t& node) const noexcept {
+  return controllerIdx[node];
+}
+
+uint32_t QuadTree::split(const uint32_t& leaf, const SplitLayout& layout) {
+  if (!isLeaf(leaf)) return leaf;
+
+  const auto parentX{x[leaf]}, parentY{y[leaf]};
+  const auto parentWidth{width[leaf]}, parentHeight{height[leaf]};
+
+  std::array<glm::vec4, maxChildren> rects{};
+  size_t count{};
+  switch (layout) {
+  case SplitLayout::SideBySide:
+    rects[count++] = {parentX, parentY, parentWidth / 2, parentHeight};
+    rects[count++] = {parentX + parentWidth / 2, parentY, parentWidth / 2,
+                      parentHeight};
+    break;
+  case SplitLayout::Stacked:
+    rects[count++] = {parentX, parentY, parentWidth, parentHeight / 2};
+    rects[count++] = {parentX, parentY + parentHeight / 2, parentWidth,
+                      parentHeight / 2};
+    break;
+  case SplitLayout::Quad:
+    for (size_t i = 0; i < 4; i++)
+      rects[count++] = {parentX + (i % 2) * parentWidth / 2,
+                        parentY + (i / 2) * parentHeight / 2, parentWidth / 2,
+                        parentHeight / 2};
+    break;
+  }
+
+  eraseLeaf(leaf);
+
+  // Every other child gets a fresh camera; the rest keep looking through the
+  // parent's camera.
+  for (size_t i = 0; i < count; i++) {
+    const auto controller{i % 2 == 0 ? acquireController()
+                                     : controllerIdx[leaf]};
+    const auto child{allocateNode(rects[i].z, rects[i].w, rects[i].x,
+                                  rects[i].y, controller, leaf)};
+    children[leaf][i] = child;
+    insertLeaf(child);
+  }
+  childCount[leaf] = static_cast<uint8_t>(count);
+  _version++;
+
+  return children[leaf][0];
+}
+
+uint32_t QuadTree::splitAlongLongerSide(const uint32_t& leaf) {
+  return split(leaf, width[leaf] >= height[leaf] ? SplitLayout::SideBySide
+                                                 : SplitLayout::Stacked);
+}
+
+void QuadTree::merge(const uint32_t& node) {
+  if (isLeaf(node)) return;
+
+  for (size_t i = 0; i < childCount[node]; i++)
+    releaseSubtree(children[node][i]);
+  childCount[node] = 0;
+
+  insertLeaf(node);
+  _version++;
+}
+
+uint32_t QuadTree::allocateNode(float _width, float _height, float _x,
+                                float _y, uint32_t _controllerIdx,
+                                uint32_t _parentIdx) {
+  controllerRefCount[_controllerIdx]++;
+
+  if (!freeNodes.empty()) {
+    const auto node{freeNodes.back()};
+    freeNodes.pop_back();
+    x[node] = _x;
+    y[node] = _y;
+    width[node] = _width;
+    height[node] = _height;
+    controllerIdx[node] = _controllerIdx;
+    parentIdx[node] = _parentIdx;
+    childCount[node] = 0;
+    leafSlot[node] = nullNode;
+    return node;
+  }
+
+  x.push_back(_x);
+  y.push_back(_y);
+  width.push_back(_width);
+  height.push_back(_height);
+  controllerIdx.push_back(_controllerIdx);
+  parentIdx.push_back(_parentIdx);
+  children.push_back({});
+  childCount.push_back(0);
+  leafSlot.push_back(nullNode);
+  return static_cast<uint32_t>(x.size() - 1);
+}
+
+void QuadTree::releaseSubtree(const uint32_t& node) {
+  if (isLeaf(node)) eraseLeaf(node);
+  for (size_t i = 0; i < childCount[node]; i++)
+    releaseSubtree(children[node][i]);
+
+  releaseController(controllerIdx[node]);
+  childCount[node] = 0;
+  freeNodes.push_back(node);
+}
+
+glm::vec3 QuadTree::randomPosition() {
+  CounterRng rng{seed, cameraStreams + placedControllers++};
+  return {rng.uniform(-0.9f, 0.9f), rng.uniform(0.2f, 0.9f),
+          rng.uniform(-0.9f, 0.9f)};
+}
+
+uint32_t QuadTree::acquireController() {
+  if (!freeControllers.empty()) {
+    const auto idx{freeControllers.back()};
+    freeControllers.pop_back();
+    controllers[idx] = FirstPersonController{randomPosition()};
+    return idx;
   }
+
+  controllers.emplace_back(randomPosition());
+  controllerRefCount.push_back(0);
+  return static_cast<uint32_t>(controllers.size() - 1);
 }
 
-static const size_t getParentIdx(const size_t& idx) noexcept {
-  return (idx + 1) / 2 - 1;
+void QuadTree::releaseController(const uint32_t& idx) {
+  if (--controllerRefCount[idx] == 0) freeControllers.push_back(idx);
 }
 
-static const size_t getDepth(const size_t& idx) noexcept {
-  return static_cast<size_t>(std::floor(std::log2(idx + 1)));
+void QuadTree::insertLeaf(const uint32_t& node) {
+  leafSlot[node] = static_cast<uint32_t>(leafNode.size());
+  leafX.push_back(x[node]);
+  leafY.push_back(y[node]);
+  leafWidth.push_back(width[node]);
+  leafHeight.push_back(height[node]);
+  leafControllerIdx.push_back(controllerIdx[node]);
+  leafNode.push_back(node);
 }
 
-static const glm::vec3 generateRandomPosition() noexcept {
-  std::random_device rd;
-  std::mt19937 engine(rd());
-  std::uniform_real_distribution<> locationDistribution(-0.9, 0.9);
-  std::uniform_real_distribution<> heightDistribution(0.2, 0.9);
+void QuadTree::eraseLeaf(const uint32_t& node) {
+  const auto slot{leafSlot[node]};
+  const auto last{leafNode.size() - 1};
+
+  leafX[slot] = leafX[last];
+  leafY[slot] = leafY[last];
+  leafWidth[slot] = leafWidth[last];
+  leafHeight[slot] = leafHeight[last];
+  leafControllerIdx[slot] = leafControllerIdx[last];
+  leafNode[slot] = leafNode[last];
+  leafSlot[leafNode[slot]] = slot;
 
-  const glm::vec3 position{locationDistribution(engine),
-                           heightDistribution(engine),
-                           locationDistribution(engine)};
-  return position;
+  leafX.pop_back();
+  leafY.pop_back();
+  leafWidth.pop_back();
+  leafHeight.pop_back();
+  leafControllerIdx.pop_back();
+  leafNode.pop_back();
+  leafSlot[node] = nullNode;
 }
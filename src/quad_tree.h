@@ -1,31 +1,93 @@
 #pragma once
+#include <array>
 #include <cmath>
-#include <random>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <vector>
 
-#include <GLFW/glfw3.h>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
+#include "counter_rng.h"
 #include "user_control.h"
 
-class QuadTreeNode {
-public:
-  QuadTreeNode(float _width, float _height, float _x, float _y,
-               std::shared_ptr<FirstPersonController> _firstPersonController)
-      : width(_width), height(_height), x(_x), y(_y),
-        firstPersonController(_firstPersonController) {}
-  float width;
-  float height;
-  float x;
-  float y;
-  std::shared_ptr<FirstPersonController> firstPersonController;
+// Non-owning view over the leaves of a QuadTree. The spans alias the tree's
+// dense leaf storage and are invalidated by any split or merge.
+struct QuadTreeLeaves {
+  std::span<const float> x;
+  std::span<const float> y;
+  std::span<const float> width;
+  std::span<const float> height;
+  std::span<const uint32_t> controllerIdx;
+  std::span<const uint32_t> node;
+
+  size_t size() const noexcept { return x.size(); }
 };
 
-std::vector<std::shared_ptr<QuadTreeNode>>
-getQuadTreeLeaves(std::vector<std::shared_ptr<QuadTreeNode>>& tree);
-void shrinkQuadTree(std::vector<std::shared_ptr<QuadTreeNode>>& tree);
-void growQuadTree(std::vector<std::shared_ptr<QuadTreeNode>>& tree,
-                  GLFWwindow* window, bool inheritParentController);
-static const size_t getParentIdx(const size_t& idx) noexcept;
-static const size_t getDepth(const size_t& idx) noexcept;
-static const glm::vec3 generateRandomPosition() noexcept;
+// SideBySide halves the width, Stacked halves the height and Quad does both.
+enum class SplitLayout { SideBySide, Stacked, Quad };
+
+// Split tree whose nodes live in a pooled structure-of-arrays store. Freed
+// nodes and controllers go to free lists, so once the pools have reached
+// their high-water mark, split and merge no longer allocate. Leaves are kept
+// in a separate dense array so they can be handed out as spans.
+//
+// New cameras are placed at random from the seed, the nth one drawing from
+// stream cameraStreams + n, past any stream a sphere takes.
+class QuadTree {
+public:
+  static constexpr uint32_t nullNode{std::numeric_limits<uint32_t>::max()};
+  static constexpr size_t maxChildren{4};
+  static constexpr uint64_t cameraStreams{uint64_t{1} << 63};
+
+  QuadTree(const glm::vec3& rootPosition, const uint64_t& seed);
+  QuadTreeLeaves leaves() const noexcept;
+  FirstPersonController& controller(const uint32_t& idx);
+  const FirstPersonController& controller(const uint32_t& idx) const;
+  uint64_t version() const noexcept;
+  uint32_t root() const noexcept;
+  uint32_t parent(const uint32_t& node) const noexcept;
+  bool isLeaf(const uint32_t& node) const noexcept;
+  uint32_t leafAt(const float& pointX, const float& pointY) const noexcept;
+  uint32_t controllerIdxOf(const uint32_t& node) const noexcept;
+  uint32_t split(const uint32_t& leaf, const SplitLayout& layout);
+  uint32_t splitAlongLongerSide(const uint32_t& leaf);
+  void merge(const uint32_t& node);
+
+private:
+  uint64_t _version{};
+
+  std::vector<float> x{};
+  std::vector<float> y{};
+  std::vector<float> width{};
+  std::vector<float> height{};
+  std::vector<uint32_t> controllerIdx{};
+  std::vector<uint32_t> parentIdx{};
+  std::vector<std::array<uint32_t, maxChildren>> children{};
+  std::vector<uint8_t> childCount{};
+  std::vector<uint32_t> leafSlot{};
+  std::vector<uint32_t> freeNodes{};
+
+  std::vector<float> leafX{};
+  std::vector<float> leafY{};
+  std::vector<float> leafWidth{};
+  std::vector<float> leafHeight{};
+  std::vector<uint32_t> leafControllerIdx{};
+  std::vector<uint32_t> leafNode{};
+
+  std::vector<FirstPersonController> controllers{};
+  std::vector<uint32_t> controllerRefCount{};
+  std::vector<uint32_t> freeControllers{};
+  uint64_t seed{};
+  uint64_t placedControllers{};
+
+  uint32_t allocateNode(float _width, float _height, float _x, float _y,
+                        uint32_t _controllerIdx, uint32_t _parentIdx);
+  void releaseSubtree(const uint32_t& node);
+  glm::vec3 randomPosition();
+  uint32_t acquireController();
+  void releaseController(const uint32_t& idx);
+  void insertLeaf(const uint32_t& node);
+  void eraseLeaf(const uint32_t& node);
+};
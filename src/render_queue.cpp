@@ -0,0 +1,335 @@
+#include "render_queue.h"
+
+// Packets drawn with several views at once are ordered by the depth in the
+// first of them. Screen sizes are measured from the eye of each view matrix;
+// the view position of the camera block is where lighting is computed from,
+// which the bird view moves away from the eye.
+void RenderQueue::begin(const CameraUniformBuffer& cameraUniforms,
+                        const GLsizei& viewCount, const bool& _isMultiView) {
+  const auto& camera{cameraUniforms.cameraBlock()};
+  const auto& viewportHeights{cameraUniforms.viewportHeights()};
+
+  view = camera.views[0];
+  _viewCount = viewCount;
+  isMultiView = _isMultiView;
+  for (GLsizei i = 0; i < viewCount; i++) {
+    frusta[i] = Frustum{camera.projs[i] * camera.views[i]};
+    _cullStats[i] = {};
+    eyePositions[i] = glm::vec3{glm::inverse(camera.views[i])[3]};
+    pixelScales[i] = camera.projs[i][1][1] * viewportHeights[i] / 2.0f;
+  }
+  _lodStats = {};
+  packets.clear();
+  entries.clear();
+}
+
+void RenderQueue::setLodSettings(const LodSettings& settings) noexcept {
+  lodSettings = settings;
+}
+
+// The per-draw programs only work through submitIndirect, so they are handed
+// out whenever submit will use it.
+const GLuint&
+RenderQueue::programOf(const ShaderProgramProvider& provider) const {
+  if (isMultiDrawIndirectSupported()) [[likely]]
+    return provider.perDrawProgram(isMultiView);
+  return isMultiView ? provider.multiViewProgram() : provider.program();
+}
+
+GLsizei RenderQueue::viewCount() const noexcept { return _viewCount; }
+
+bool RenderQueue::isVisible(const BoundingSphere& bounds) {
+  return cull({&bounds, 1})[0] != 0;
+}
+
+// Tests every bounding sphere against each view and counts the result per
+// view. An object is kept when any view sees it, since a multi-view draw
+// covers all of them at once, and when it is at least dropRadius pixels in
+// one of them.
+std::span<const uint8_t>
+RenderQueue::cull(std::span<const BoundingSphere> bounds) {
+  visibleMask.assign(bounds.size(), 0);
+  viewMask.resize(bounds.size());
+
+  for (GLsizei i = 0; i < _viewCount; i++) {
+    frusta[i].intersects(bounds, viewMask);
+
+    uint32_t visible{};
+    for (size_t j = 0; j < bounds.size(); j++) {
+      visible += viewMask[j];
+      visibleMask[j] |= viewMask[j];
+    }
+    _cullStats[i].visible += visible;
+    _cullStats[i].culled += static_cast<uint32_t>(bounds.size()) - visible;
+  }
+
+  for (size_t j = 0; j < bounds.size(); j++)
+    if (visibleMask[j] && pixelRadius(bounds[j]) < lodSettings.dropRadius) {
+      visibleMask[j] = 0;
+      _lodStats.dropped++;
+    }
+
+  return visibleMask;
+}
+
+// Picks the finest level the sphere's largest projected radius qualifies for.
+SphereLod RenderQueue::sphereLod(const BoundingSphere& bounds) {
+  const auto radius{pixelRadius(bounds) / lodSettings.lodBias};
+  const auto& levelRadii{lodSettings.levelRadii};
+
+  auto level{levelRadii.size()};
+  while (level > 0 && radius < levelRadii[level - 1]) level--;
+  if (level < levelRadii.size()) _lodStats.demoted++;
+  return static_cast<SphereLod>(level);
+}
+
+const LodStats& RenderQueue::lodStats() const noexcept { return _lodStats; }
+
+std::span<const CullStats> RenderQueue::cullStats() const noexcept {
+  return {_cullStats.data(), static_cast<size_t>(_viewCount)};
+}
+
+// The same tests cull and sphereLod run, packed for a compute shader. The
+// level radii are multiplied by the bias rather than the pixel radius divided
+// by it.
+CullBlock RenderQueue::cullBlock() const {
+  CullBlock block{.viewCount{_viewCount}};
+  for (GLsizei i = 0; i < _viewCount; i++) {
+    std::copy(frusta[i].planes().begin(), frusta[i].planes().end(),
+              block.planes.begin() + i * 6);
+    block.eyePositionScales[i] = glm::vec4{eyePositions[i], pixelScales[i]};
+  }
+
+  const auto& levelRadii{lodSettings.levelRadii};
+  block.levelRadii = glm::vec4{levelRadii[0], levelRadii[1], levelRadii[2],
+                               0.0f} *
+                     lodSettings.lodBias;
+  block.levelRadii.w = lodSettings.dropRadius;
+  return block;
+}
+
+void RenderQueue::push(const DrawPacket& packet) {
+  entries.push_back(
+      {.key{sortKey(packet)}, .index{static_cast<uint32_t>(packets.size())}});
+  packets.push_back(packet);
+}
+
+// LSD radix sort over the key, one byte per pass. Bytes that are the same in
+// every key are skipped, which with a handful of programs and VAOs leaves
+// only a few passes to run.
+void RenderQueue::sort() {
+  scratch.resize(entries.size());
+
+  for (size_t shift = 0; shift < 64; shift += 8) {
+    std::array<uint32_t, 256> offsets{};
+    for (const auto& entry : entries) offsets[(entry.key >> shift) & 0xFF]++;
+    if (std::find(offsets.begin(), offsets.end(), entries.size()) !=
+        offsets.end())
+      continue;
+
+    uint32_t sum{};
+    for (auto& offset : offsets) {
+      const auto count{offset};
+      offset = sum;
+      sum += count;
+    }
+    for (const auto& entry : entries)
+      scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+    entries.swap(scratch);
+  }
+}
+
+bool RenderQueue::isMultiDrawIndirectSupported() {
+  static const bool supported{
+      GLAD_GL_VERSION_4_3 ||
+      (GLAD_GL_VERSION_4_2 &&
+       glfwExtensionSupported("GL_ARB_multi_draw_indirect"))};
+  return supported;
+}
+
+void RenderQueue::submit() {
+  if (isMultiDrawIndirectSupported()) [[likely]]
+    submitIndirect();
+  else
+    submitDirect();
+}
+
+void RenderQueue::submitDirect() const {
+  for (const auto& entry : entries) {
+    const auto& packet{packets[entry.index]};
+    applyState(packet);
+
+    if (packet.indexed)
+      glDrawElementsInstanced(
+          packet.primitive, packet.count, GL_UNSIGNED_INT,
+          (GLvoid*)(packet.first * sizeof(GLuint)), packet.instanceCount);
+    else
+      glDrawArraysInstanced(packet.primitive, packet.first, packet.count,
+                            packet.instanceCount);
+  }
+}
+
+static bool isSameBatch(const DrawPacket& a, const DrawPacket& b) {
+  return a.indirectBuffer == 0 && b.indirectBuffer == 0 &&
+         a.program == b.program && a.vao == b.vao && a.texture == b.texture &&
+         a.primitive == b.primitive && a.indexed == b.indexed &&
+         (readsPerDrawAttributes(a.program) ||
+          (a.model == b.model && a.color == b.color));
+}
+
+// Elements and arrays commands go to two regions of the same buffer, which is
+// orphaned and refilled once per view, as is the buffer of per-draw
+// attributes. Packets bringing their own commands are batches of their own
+// and take nothing from either.
+void RenderQueue::submitIndirect() {
+  elementCommands.clear();
+  arrayCommands.clear();
+  batches.clear();
+  drawAttributes.clear();
+
+  for (uint32_t i = 0; i < entries.size(); i++) {
+    const auto& packet{packets[entries[i].index]};
+    if (packet.indirectBuffer != 0) {
+      batches.push_back({.firstEntry{i}, .drawCount{packet.drawCount}});
+      continue;
+    }
+    const auto commands{packet.indexed ? elementCommands.size()
+                                       : arrayCommands.size()};
+
+    if (i == 0 || !isSameBatch(packets[entries[i - 1].index], packet))
+      batches.push_back(
+          {.firstEntry{i},
+           .drawCount{0},
+           .offset{commands * (packet.indexed
+                                   ? sizeof(DrawElementsIndirectCommand)
+                                   : sizeof(DrawArraysIndirectCommand))}});
+    batches.back().drawCount++;
+
+    // Other instanced attributes start at the first instance, so only the
+    // commands of per-draw programs move their base instance.
+    GLuint baseInstance{};
+    if (readsPerDrawAttributes(packet.program)) {
+      baseInstance = static_cast<GLuint>(drawAttributes.size());
+      drawAttributes.push_back({.model{packet.model}, .color{packet.color}});
+    }
+    if (packet.indexed)
+      elementCommands.push_back(
+          {.count{static_cast<GLuint>(packet.count)},
+           .instanceCount{static_cast<GLuint>(packet.instanceCount)},
+           .firstIndex{static_cast<GLuint>(packet.first)},
+           .baseVertex{0},
+           .baseInstance{baseInstance}});
+    else
+      arrayCommands.push_back(
+          {.count{static_cast<GLuint>(packet.count)},
+           .instanceCount{static_cast<GLuint>(packet.instanceCount)},
+           .first{static_cast<GLuint>(packet.first)},
+           .baseInstance{baseInstance}});
+  }
+  if (batches.empty()) return;
+
+  const auto elementBytes{elementCommands.size() *
+                          sizeof(DrawElementsIndirectCommand)};
+  const auto arrayBytes{arrayCommands.size() *
+                        sizeof(DrawArraysIndirectCommand)};
+  if (indirectBuffer == 0) glGenBuffers(1, &indirectBuffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, elementBytes + arrayBytes, nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, elementBytes,
+                  elementCommands.data());
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, elementBytes, arrayBytes,
+                  arrayCommands.data());
+
+  if (drawAttributeBuffer == 0) glGenBuffers(1, &drawAttributeBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, drawAttributeBuffer);
+  glBufferData(GL_ARRAY_BUFFER, drawAttributes.size() * sizeof(DrawAttributes),
+               drawAttributes.data(), GL_STREAM_DRAW);
+
+  for (const auto& batch : batches) {
+    const auto& packet{packets[entries[batch.firstEntry].index]};
+    applyState(packet);
+    if (readsPerDrawAttributes(packet.program))
+      attachDrawAttributes(packet.vao);
+
+    if (packet.indirectBuffer != 0) {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, packet.indirectBuffer);
+      glMultiDrawElementsIndirect(packet.primitive, GL_UNSIGNED_INT, nullptr,
+                                  batch.drawCount, 0);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    } else if (packet.indexed)
+      glMultiDrawElementsIndirect(packet.primitive, GL_UNSIGNED_INT,
+                                  (GLvoid*)batch.offset, batch.drawCount, 0);
+    else
+      glMultiDrawArraysIndirect(packet.primitive,
+                                (GLvoid*)(elementBytes + batch.offset),
+                                batch.drawCount, 0);
+  }
+}
+
+// Points the per-draw attributes of a VAO at their buffer the first time it
+// is drawn with a per-draw program; orphaning keeps the buffer's name, so
+// that holds from then on. A command has at most maxViews instances, one per
+// view, so with that divisor they all read the attributes at its base
+// instance.
+void RenderQueue::attachDrawAttributes(const GLuint& vao) {
+  if (isDrawAttributeVao.size() <= vao) isDrawAttributeVao.resize(vao + 1);
+  if (isDrawAttributeVao[vao]) [[likely]] return;
+  isDrawAttributeVao[vao] = 1;
+
+  glBindBuffer(GL_ARRAY_BUFFER, drawAttributeBuffer);
+  for (GLuint column = 0; column < 4; column++)
+    glVertexAttribPointer(drawModelLocation + column, 4, GL_FLOAT, GL_FALSE,
+                          sizeof(DrawAttributes),
+                          (GLvoid*)(offsetof(DrawAttributes, model) +
+                                    column * sizeof(glm::vec4)));
+  glVertexAttribPointer(drawColorLocation, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(DrawAttributes),
+                        (GLvoid*)offsetof(DrawAttributes, color));
+  for (auto location = drawModelLocation; location <= drawColorLocation;
+       location++) {
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, CameraUniformBuffer::maxViews);
+  }
+}
+
+void RenderQueue::applyState(const DrawPacket& packet) const {
+  RenderState::useProgram(packet.program);
+  RenderState::bindVertexArray(packet.vao);
+  if (packet.texture != 0) RenderState::bindTexture(packet.texture);
+  RenderState::polygonMode(GL_FILL);
+
+  if (uniformLocation(packet.program, "model") != -1)
+    setUniformToProgram(packet.program, "model", packet.model);
+  if (uniformLocation(packet.program, "color") != -1)
+    setUniformToProgram(packet.program, "color", packet.color);
+  if (uniformLocation(packet.program, "viewCount") != -1)
+    setUniformToProgram(packet.program, "viewCount", _viewCount);
+}
+
+// The largest radius the sphere projects to in any of the views, in pixels.
+// A view from inside the sphere counts as infinitely large.
+float RenderQueue::pixelRadius(const BoundingSphere& bounds) const {
+  auto radius{0.0f};
+  for (GLsizei i = 0; i < _viewCount; i++) {
+    const auto distance{glm::length(glm::vec3{bounds} - eyePositions[i])};
+    if (distance <= bounds.w) return std::numeric_limits<float>::infinity();
+    radius = std::max(radius, bounds.w * pixelScales[i] / distance);
+  }
+  return radius;
+}
+
+uint64_t RenderQueue::sortKey(const DrawPacket& packet) const {
+  constexpr auto farPlane{100.0f};
+  constexpr uint64_t depthMax{(1 << 24) - 1};
+
+  const auto viewDepth{-(view * glm::vec4{packet.center, 1.0f}).z};
+  auto depth{static_cast<uint64_t>(
+      std::clamp(viewDepth / farPlane, 0.0f, 1.0f) * depthMax)};
+  if (packet.pass == RenderPass::Transparent) depth = depthMax - depth;
+
+  return static_cast<uint64_t>(packet.pass) << 62 |
+         (static_cast<uint64_t>(packet.program) & 0x3FFF) << 48 |
+         (static_cast<uint64_t>(packet.vao) & 0x3FFF) << 34 |
+         (static_cast<uint64_t>(packet.texture) & 0x3FF) << 24 | depth;
+}
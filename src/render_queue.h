@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustum.h"
+#include "render_state.h"
+#include "shader.h"
+#include "sphere_mesh.h"
+#include "uniform_blocks.h"
+
+// Opaque packets are drawn front to back, transparent ones after them back
+// to front.
+enum class RenderPass : uint8_t { Opaque, Transparent };
+
+// Screen-size thresholds, all in pixels of projected radius. Objects smaller
+// than dropRadius are not drawn at all; spheres take the finest level whose
+// entry in levelRadii they reach, scaled by lodBias, and Level0 below that.
+struct LodSettings {
+  float dropRadius{1.0f};
+  float lodBias{1.0f};
+  std::array<float, 3> levelRadii{6.0f, 16.0f, 48.0f};
+};
+
+// Objects of a frame left out for being too small, and spheres drawn with a
+// coarser level than the finest one in LodSettings.
+struct LodStats {
+  uint32_t demoted;
+  uint32_t dropped;
+};
+
+// Laid out as glMultiDrawElementsIndirect and glMultiDrawArraysIndirect read
+// them.
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+  GLuint baseInstance;
+};
+struct DrawArraysIndirectCommand {
+  GLuint count;
+  GLuint instanceCount;
+  GLuint first;
+  GLuint baseInstance;
+};
+
+// Everything needed to issue one draw. The model matrix and color are only
+// uploaded when the packet's program declares them, as uniforms or, for the
+// per-draw programs, as attributes.
+//
+// A packet with an indirectBuffer draws the drawCount element commands found
+// there instead of first, count and instanceCount, which is how commands
+// written on the GPU are drawn. It needs multi-draw indirect support.
+struct DrawPacket {
+  RenderPass pass{RenderPass::Opaque};
+  GLuint program{};
+  GLuint vao{};
+  GLuint texture{};
+  GLenum primitive{GL_TRIANGLES};
+  bool indexed{};
+  GLint first{};
+  GLsizei count{};
+  GLsizei instanceCount{1};
+  GLuint indirectBuffer{};
+  GLsizei drawCount{1};
+  glm::vec3 center{};
+  glm::mat4 model{1.0f};
+  glm::vec4 color{1.0f};
+};
+
+// Collects the draws of one view (or one multi-view batch), sorts them by a
+// 64-bit key and submits them through RenderState, so draws sharing a
+// program, VAO and texture end up next to each other. From the most to the
+// least significant bits, the key holds the pass, program, VAO, texture and
+// the quantized view depth of the packet's center.
+//
+// The queue also holds the frusta and pixel scales of the views it is filled
+// for, so components can drop what none of the views can see, or what would
+// cover less than a pixel, before pushing it.
+//
+// Neighbouring packets that differ only in their range and instance count
+// form a batch. With multi-draw indirect, every command of a view is written
+// to one indirect buffer and each batch is a single glMultiDraw*Indirect
+// call; without it, the packets are drawn one by one. programOf then hands
+// out the per-draw programs, whose model matrix and color are written next
+// to the commands and found through each command's base instance, so those
+// do not split batches either.
+class RenderQueue {
+public:
+  static bool isMultiDrawIndirectSupported();
+  void begin(const CameraUniformBuffer& cameraUniforms,
+             const GLsizei& viewCount, const bool& isMultiView);
+  void setLodSettings(const LodSettings& settings) noexcept;
+  const GLuint& programOf(const ShaderProgramProvider& provider) const;
+  GLsizei viewCount() const noexcept;
+  bool isVisible(const BoundingSphere& bounds);
+  std::span<const uint8_t> cull(std::span<const BoundingSphere> bounds);
+  std::span<const CullStats> cullStats() const noexcept;
+  SphereLod sphereLod(const BoundingSphere& bounds);
+  const LodStats& lodStats() const noexcept;
+  CullBlock cullBlock() const;
+  void push(const DrawPacket& packet);
+  void sort();
+  void submit();
+
+private:
+  struct SortEntry {
+    uint64_t key;
+    uint32_t index;
+  };
+
+  // What the per-draw programs read at drawModelLocation and
+  // drawColorLocation.
+  struct DrawAttributes {
+    glm::mat4 model;
+    glm::vec4 color;
+  };
+
+  // A run of sorted entries drawn by one call, starting at the given offset
+  // into the indirect buffer.
+  struct IndirectBatch {
+    uint32_t firstEntry;
+    GLsizei drawCount;
+    size_t offset;
+  };
+
+  glm::mat4 view{1.0f};
+  GLsizei _viewCount{1};
+  bool isMultiView{};
+  std::array<Frustum, CameraUniformBuffer::maxViews> frusta{};
+  std::array<CullStats, CameraUniformBuffer::maxViews> _cullStats{};
+  std::array<glm::vec3, CameraUniformBuffer::maxViews> eyePositions{};
+  std::array<float, CameraUniformBuffer::maxViews> pixelScales{};
+  LodSettings lodSettings{};
+  LodStats _lodStats{};
+  std::vector<uint8_t> visibleMask{};
+  std::vector<uint8_t> viewMask{};
+  std::vector<DrawPacket> packets{};
+  std::vector<SortEntry> entries{};
+  std::vector<SortEntry> scratch{};
+  GLuint indirectBuffer{};
+  std::vector<DrawElementsIndirectCommand> elementCommands{};
+  std::vector<DrawArraysIndirectCommand> arrayCommands{};
+  std::vector<IndirectBatch> batches{};
+  GLuint drawAttributeBuffer{};
+  std::vector<DrawAttributes> drawAttributes{};
+  std::vector<uint8_t> isDrawAttributeVao{};
+
+  void submitDirect() const;
+  void submitIndirect();
+  void applyState(const DrawPacket& packet) const;
+  void attachDrawAttributes(const GLuint& vao);
+  uint64_t sortKey(const DrawPacket& packet) const;
+  float pixelRadius(const BoundingSphere& bounds) const;
+};
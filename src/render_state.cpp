@@ -0,0 +1,52 @@
+#include "render_state.h"
+
+void RenderState::bindVertexArray(const GLuint& vao) {
+  if (currentVertexArray == vao) [[likely]] {
+    _counters.elided++;
+    return;
+  }
+  glBindVertexArray(vao);
+  currentVertexArray = vao;
+  _counters.issued++;
+}
+
+void RenderState::useProgram(const GLuint& program) {
+  if (currentProgram == program) [[likely]] {
+    _counters.elided++;
+    return;
+  }
+  glUseProgram(program);
+  currentProgram = program;
+  _counters.issued++;
+}
+
+// Only texture unit 0 is ever used, so the GL_TEXTURE_2D binding of that
+// unit is all there is to track.
+void RenderState::bindTexture(const GLuint& texture) {
+  if (currentTexture == texture) [[likely]] {
+    _counters.elided++;
+    return;
+  }
+  glBindTexture(GL_TEXTURE_2D, texture);
+  currentTexture = texture;
+  _counters.issued++;
+}
+
+void RenderState::polygonMode(const GLenum& mode) {
+  if (currentPolygonMode == mode) [[likely]] {
+    _counters.elided++;
+    return;
+  }
+  glPolygonMode(GL_FRONT_AND_BACK, mode);
+  currentPolygonMode = mode;
+  _counters.issued++;
+}
+
+void RenderState::invalidate() {
+  currentVertexArray = unknown;
+  currentProgram = unknown;
+  currentTexture = unknown;
+  currentPolygonMode = unknown;
+}
+
+const RenderStateCounters& RenderState::counters() { return _counters; }
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+#include <glad/glad.h>
+
+struct RenderStateCounters {
+  uint64_t issued{};
+  uint64_t elided{};
+};
+
+// Shadow copy of the binding state the components change between draws.
+// Every bind goes through here, and a bind of what is already current is
+// dropped before it reaches the driver. Code that changes these bindings
+// directly must call invalidate afterwards.
+class RenderState {
+public:
+  static void bindVertexArray(const GLuint& vao);
+  static void useProgram(const GLuint& program);
+  static void bindTexture(const GLuint& texture);
+  static void polygonMode(const GLenum& mode);
+  static void invalidate();
+  static const RenderStateCounters& counters();
+
+private:
+  static constexpr GLuint unknown{~GLuint{}};
+
+  static inline GLuint currentVertexArray{unknown};
+  static inline GLuint currentProgram{unknown};
+  static inline GLuint currentTexture{unknown};
+  static inline GLenum currentPolygonMode{unknown};
+  static inline RenderStateCounters _counters{};
+};
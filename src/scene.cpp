@@ -1,164 +1,305 @@
 #include "scene.h"
 
-AnimatedSphereData generateRandomAnimatedSphereData() noexcept;
+// Bakes every instance into the batch of its material, with one texture per
+// path however many materials share it. The layout only has to last until
+// the batches are uploaded, which drops their CPU copies.
+Scene::Scene(const StaticLayout& layout) {
+  materialBatches.reserve(layout.materials.size());
+  for (const auto& material : layout.materials) {
+    const std::string texture{material.texture.data()};
+    const auto& textureProvider{
+        textureProviders.try_emplace(texture, texture).first->second};
+    materialBatches.push_back(
+        {.batch{StaticBatch{textureProvider}},
+         .isHiddenInBirdView{material.isHiddenInBirdView != 0}});
+  }
+
+  for (const auto& instance : layout.instances) {
+    auto& batch{materialBatches[instance.material].batch};
+    if (instance.mesh == StaticMesh::Wall)
+      WallComponent{instance.model}.bake(batch);
+    else
+      FloorComponent{instance.model}.bake(batch);
+  }
 
-Scene::Scene(const float& viewAspectRatio) {
-  updateViewAspectRatio(viewAspectRatio);
-  addWalls();
-  addFloor();
-  addCeiling();
+  for (auto& materialBatch : materialBatches) materialBatch.batch.upload();
 }
 
-void Scene::render(const glm::mat4& view, const SceneData& data,
-                   const glm::vec3& viewPosition,
-                   std::vector<std::shared_ptr<QuadTreeNode>> treeLeafs) const {
-  for (const auto& component : staticComponents)
-    std::visit([&](const auto& c) { c.render(view, proj); }, component);
+// Draws the scene from the camera in slot 0 of the Camera block, which must
+// already be uploaded.
+void Scene::render(const CameraUniformBuffer& cameraUniforms,
+                   const SceneData& data, const QuadTree& quadTree) const {
+  renderQueue.begin(cameraUniforms, 1, false);
+
+  axes.enqueue(renderQueue);
+  grid.enqueue(renderQueue);
+  enqueueStatic(data.isBirdView);
+  lightSource.enqueue(renderQueue);
+  enqueueSpheres();
+
+  if (data.isBirdView) {
+    const auto leaves{quadTree.leaves()};
+    for (size_t i = 0; i < leaves.size(); i++) {
+      const auto& controller{quadTree.controller(leaves.controllerIdx[i])};
+      CameraComponent cameraComponent(controller.position());
+      cameraComponent.enqueue(renderQueue, controller.horizontalAngleRadians(),
+                              controller.verticalAngleRadians());
+    }
+  }
+
+  renderQueue.sort();
+  renderQueue.submit();
 
-  for (const auto& component : lightingComponents)
-    std::visit(
-        [&](const auto& c) {
-          c.render(view, proj, viewPosition, lightSource.position());
-        },
-        component);
+  const auto stats{renderQueue.cullStats()};
+  frameCullStats.insert(frameCullStats.end(), stats.begin(), stats.end());
+  frameLodStats.demoted += renderQueue.lodStats().demoted;
+  frameLodStats.dropped += renderQueue.lodStats().dropped;
+}
 
-  lightSource.render(view, proj);
+// Multi-view counterpart of render: every draw is instanced once per view
+// set up by MultiViewRenderer::prepare. The bird view never goes through
+// here, so the camera gizmos are left out.
+void Scene::renderViews(const CameraUniformBuffer& cameraUniforms,
+                        const GLsizei& viewCount) const {
+  renderQueue.begin(cameraUniforms, viewCount, true);
 
-  renderSpheres(view, viewPosition, data.spheres);
+  axes.enqueue(renderQueue);
+  grid.enqueue(renderQueue);
+  enqueueStatic(false);
+  lightSource.enqueue(renderQueue);
+  enqueueSpheres();
 
-  if (!data.isBirdView)
-    for (const auto& cellingComponent : cellingComponents)
-      cellingComponent.render(view, proj, viewPosition, lightSource.position());
+  renderQueue.sort();
+  renderQueue.submit();
 
-  if (data.isBirdView) {
-    for (auto& treeLeaf : treeLeafs) {
-      CameraComponent cameraComponent(
-          treeLeaf->firstPersonController->position());
-      cameraComponent.render(
-          view, proj, treeLeaf->firstPersonController->horizontalAngleRadians(),
-          treeLeaf->firstPersonController->verticalAngleRadians(), viewPosition,
-          lightSource.position());
-    }
+  const auto stats{renderQueue.cullStats()};
+  frameCullStats.insert(frameCullStats.end(), stats.begin(), stats.end());
+  frameLodStats.demoted += renderQueue.lodStats().demoted;
+  frameLodStats.dropped += renderQueue.lodStats().dropped;
+}
+
+// Uploads the per-frame state: the Light block and the sphere instance
+// buffer, or only the animation time when the orbit shader moves the
+// spheres. Called once per frame, after the scene data is updated and before
+// any view is rendered.
+void Scene::update(const SceneData& data) {
+  frameCullStats.clear();
+  frameLodStats = {};
+  frameSphereCullTime = 0.0;
+
+  lightUniforms.upload({.position{lightSource.position()},
+                        .luminousIntensity{1.0f},
+                        .ambient{glm::vec3{0.2f}},
+                        .diffuse{glm::vec3{1.0f}},
+                        .specular{glm::vec3{1.0f}}});
+
+  if (sphereAnimationMode == SphereAnimationMode::Shader) {
+    if (!areSphereOrbitsUploaded) uploadSphereOrbits(data);
+    sphereComponent.setAnimationTime(data.animationTime);
+    return;
   }
+
+  const auto& spheres{data.spheres};
+  sphereInstances.resize(spheres.size());
+  for (size_t i = 0; i < spheres.size(); i++)
+    sphereInstances[i] = {
+        .positionRadius{spheres.positionX[i], spheres.positionY[i],
+                        spheres.positionZ[i], spheres.radius[i]},
+        .color{spheres.colorR[i], spheres.colorG[i], spheres.colorB[i], 1.0f}};
+  sphereComponent.updateInstances(sphereInstances);
 }
 
-void Scene::updateViewAspectRatio(const float& viewAspectRatio) {
-  static float currentAspectRatio;
-  if (currentAspectRatio != viewAspectRatio) [[unlikely]]
-    proj = glm::mat4{
-        glm::perspective(glm::radians(45.0f), viewAspectRatio, 0.01f, 100.0f)};
-}
-
-void Scene::addWalls() {
-  for (size_t i = 0; i < 3; i++)
-    for (size_t j = 0; j < 10; j++) {
-      lightingComponents.emplace_back(
-          WallComponent{glm::vec3{-0.9 + 0.2 * j, 0.2 + i * 0.4, -1}, false});
-      lightingComponents.emplace_back(
-          WallComponent{glm::vec3{-0.9 + 0.2 * j, 0.2 + i * 0.4, 1}, false});
-      lightingComponents.emplace_back(
-          WallComponent{glm::vec3{-1, 0.2 + i * 0.4, -0.9 + 0.2 * j}, true});
-      lightingComponents.emplace_back(
-          WallComponent{glm::vec3{1, 0.2 + i * 0.4, -0.9 + 0.2 * j}, true});
-    }
+// The culling results of every view rendered since the last update, in the
+// order the views were rendered.
+std::span<const CullStats> Scene::cullStats() const noexcept {
+  return frameCullStats;
 }
 
-void Scene::addFloor() {
-  for (size_t i = 0; i < 10; i++)
-    for (size_t j = 0; j < 10; j++)
-      lightingComponents.emplace_back(
-          FloorComponent{glm::vec3{-0.9 + 0.2 * i, 0, -0.9 + 0.2 * j}});
+// Objects demoted or dropped for their screen size in every view rendered
+// since the last update.
+const LodStats& Scene::lodStats() const noexcept { return frameLodStats; }
+
+void Scene::setLodSettings(const LodSettings& settings) noexcept {
+  renderQueue.setLodSettings(settings);
+}
+
+void Scene::setSphereRenderMode(const SphereRenderMode& mode) noexcept {
+  sphereComponent.setRenderMode(mode);
 }
 
-void Scene::addCeiling() {
-  for (size_t i = 0; i < 10; i++)
-    for (size_t j = 0; j < 10; j++)
-      cellingComponents.emplace_back(
-          FloorComponent{glm::vec3{-0.9 + 0.2 * i, 1.2, -0.9 + 0.2 * j}});
+void Scene::setSphereCullMode(const SphereCullMode& mode) noexcept {
+  sphereComponent.setCullMode(mode);
 }
 
-void Scene::renderSpheres(const glm::mat4& view, const glm::vec3& viewPosition,
-                          const std::vector<AnimatedSphereData>& data) const {
-  for (size_t i = 0; i < data.size(); i++) {
-    if (sphereComponents.size() <= i)
-      sphereComponents.push_back(SphereComponent{});
+// CPU time spent culling and enqueuing the spheres in every view rendered
+// since the last update, in seconds. This is the part GPU culling moves off
+// the CPU, so comparing it between the two modes gives the time saved.
+double Scene::sphereCullTime() const noexcept { return frameSphereCullTime; }
+
+void Scene::setSphereAnimationMode(const SphereAnimationMode& mode) noexcept {
+  sphereAnimationMode = mode;
+  sphereComponent.setAnimationMode(mode);
+}
 
-    sphereComponents.at(i).render(view, proj, data.at(i).sphereData,
-                                  viewPosition, lightSource.position());
+// The orbits never change once the spheres are generated, so they are
+// uploaded the first time the orbit shader is used and kept from then on.
+void Scene::uploadSphereOrbits(const SceneData& data) {
+  const auto& spheres{data.spheres};
+  std::vector<SphereOrbitInstance> orbits(spheres.size());
+  for (size_t i = 0; i < spheres.size(); i++)
+    orbits[i] = {
+        .positionRadius{spheres.originX[i], spheres.originY[i],
+                        spheres.originZ[i], spheres.radius[i]},
+        .color{spheres.colorR[i], spheres.colorG[i], spheres.colorB[i], 1.0f},
+        .orbit{spheres.scaleX[i], spheres.scaleZ[i], spheres.cycleOffset[i],
+               spheres.speed[i]}};
+  sphereComponent.updateOrbits(orbits);
+  areSphereOrbitsUploaded = true;
+}
+
+void Scene::enqueueSpheres() const {
+  const auto start{glfwGetTime()};
+  sphereComponent.enqueue(renderQueue);
+  frameSphereCullTime += glfwGetTime() - start;
+}
+
+void Scene::enqueueStatic(const bool& isBirdView) const {
+  for (const auto& materialBatch : materialBatches)
+    if (!isBirdView || !materialBatch.isHiddenInBirdView)
+      materialBatch.batch.enqueue(renderQueue);
+}
+
+// The room: walls three tiles high around a floor and a ceiling of ten by
+// ten tiles, the ceiling being left out of the bird view.
+StaticLayout defaultStaticLayout() {
+  constexpr uint32_t wallMaterial{0};
+  constexpr uint32_t floorMaterial{1};
+  constexpr uint32_t ceilingMaterial{2};
+  const auto material{[](const std::string& texture,
+                         const bool& isHiddenInBirdView) {
+    SceneMaterial material{.isHiddenInBirdView{isHiddenInBirdView}};
+    std::copy(texture.begin(), texture.end(), material.texture.begin());
+    return material;
+  }};
+
+  static const std::vector<SceneMaterial> materials{
+      material(WallComponent::textureFile, false),
+      material(FloorComponent::textureFile, false),
+      material(FloorComponent::textureFile, true)};
+  static const auto instances{[&] {
+    std::vector<StaticInstance> instances{};
+    const auto addWall{[&](const glm::vec3& position, const bool& rotate) {
+      instances.push_back({.model{WallComponent{position, rotate}.model()},
+                           .mesh{StaticMesh::Wall},
+                           .material{wallMaterial}});
+    }};
+    const auto addFloor{[&](const glm::vec3& position,
+                            const uint32_t& material) {
+      instances.push_back({.model{FloorComponent{position}.model()},
+                           .mesh{StaticMesh::Floor},
+                           .material{material}});
+    }};
+
+    for (size_t i = 0; i < 3; i++)
+      for (size_t j = 0; j < 10; j++) {
+        addWall(glm::vec3{-0.9 + 0.2 * j, 0.2 + i * 0.4, -1}, false);
+        addWall(glm::vec3{-0.9 + 0.2 * j, 0.2 + i * 0.4, 1}, false);
+        addWall(glm::vec3{-1, 0.2 + i * 0.4, -0.9 + 0.2 * j}, true);
+        addWall(glm::vec3{1, 0.2 + i * 0.4, -0.9 + 0.2 * j}, true);
+      }
+    for (size_t i = 0; i < 10; i++)
+      for (size_t j = 0; j < 10; j++)
+        addFloor(glm::vec3{-0.9 + 0.2 * i, 0, -0.9 + 0.2 * j}, floorMaterial);
+    for (size_t i = 0; i < 10; i++)
+      for (size_t j = 0; j < 10; j++)
+        addFloor(glm::vec3{-0.9 + 0.2 * i, 1.2, -0.9 + 0.2 * j},
+                 ceilingMaterial);
+    return instances;
+  }()};
+  return {.materials{materials}, .instances{instances}};
+}
+
+// The xz box of every static instance, with each side moved in to the inner
+// face of the walls on that side. Walls are unit cubes placed by their model
+// matrices, and a wall is on the side its thinner horizontal extent faces.
+// Without any instance, the room is the -1..1 square of the default one.
+RoomBounds roomBounds(const StaticLayout& layout) {
+  if (layout.instances.empty())
+    return {.min{glm::vec2{-1.0f}}, .max{glm::vec2{1.0f}}};
+
+  const auto extent{[](const StaticInstance& instance) {
+    glm::vec2 lower{std::numeric_limits<float>::max()};
+    glm::vec2 upper{std::numeric_limits<float>::lowest()};
+    for (const auto x : {-0.5f, 0.5f})
+      for (const auto y : {-0.5f, 0.5f})
+        for (const auto z : {-0.5f, 0.5f}) {
+          const auto corner{instance.model * glm::vec4{x, y, z, 1.0f}};
+          lower = glm::min(lower, glm::vec2{corner.x, corner.z});
+          upper = glm::max(upper, glm::vec2{corner.x, corner.z});
+        }
+    return std::pair{lower, upper};
+  }};
+
+  RoomBounds outer{.min{glm::vec2{std::numeric_limits<float>::max()}},
+                   .max{glm::vec2{std::numeric_limits<float>::lowest()}}};
+  for (const auto& instance : layout.instances) {
+    const auto [lower, upper]{extent(instance)};
+    outer.min = glm::min(outer.min, lower);
+    outer.max = glm::max(outer.max, upper);
+  }
+
+  auto room{outer};
+  const auto middle{(outer.min + outer.max) / 2.0f};
+  for (const auto& instance : layout.instances) {
+    if (instance.mesh != StaticMesh::Wall) continue;
+    const auto [lower, upper]{extent(instance)};
+    const auto size{upper - lower};
+    const auto axis{size.x < size.y ? 0 : 1};
+    if ((lower[axis] + upper[axis]) / 2.0f > middle[axis])
+      room.max[axis] = std::min(room.max[axis], lower[axis]);
+    else
+      room.min[axis] = std::max(room.min[axis], upper[axis]);
   }
+  return room;
 }
 
-SceneController::SceneController() {
-  const auto numSpheres{100};
-  for (size_t i = 0; i < numSpheres; i++)
-    data.spheres.push_back(generateRandomAnimatedSphereData());
+SceneController::SceneController(const uint64_t& seed,
+                                 const size_t& sphereCount)
+    : SceneController{roomBounds(defaultStaticLayout())} {
+  generateSpheres(data.spheres, seed, sphereCount);
 }
 
+SceneController::SceneController(const SceneFile& file)
+    : SceneController{roomBounds(file.layout())} {
+  file.readSpheres(data.spheres);
+}
+
+SceneController::SceneController(const RoomBounds& room)
+    : physics{room.min, room.max} {}
+
+// Speeds are whole degrees per second, so every orbit is back where it
+// started after 360 seconds and the animation time wraps there. Physics
+// runs on the time since the previous update instead.
 void SceneController::updateSceneData(const bool& isBirdView,
                                       double currentTimestamp) {
+  const auto elapsed{currentTimestamp - lastTimestamp};
+  lastTimestamp = currentTimestamp;
   data.isBirdView = isBirdView;
+  data.animationTime =
+      static_cast<float>(std::fmod(currentTimestamp, 360.0));
+  if (animationMode == SphereAnimationMode::Shader) return;
 
-  degreeCycleCounter =
-      std::fmodf(static_cast<float>(currentTimestamp) * 50.0f, 360.0f);
-  // degreeCycleCounter = std::fmodf(degreeCycleCounter + 0.5f, 360.0f);
-
-  for (auto& sphere : data.spheres) {
-    sphere.sphereData.position.x =
-        sphere.originalPosition.x +
-        glm::sin(glm::radians(degreeCycleCounter + sphere.cycleOffset)) *
-            sphere.movingScale.x;
+  if (animationMode == SphereAnimationMode::Physics)
+    physics.advance(data.spheres, elapsed);
+  else
+    animateSpheres(data.spheres, data.animationTime);
+}
 
-    sphere.sphereData.position.z =
-        sphere.originalPosition.z +
-        glm::cos(glm::radians(degreeCycleCounter + sphere.cycleOffset)) *
-            sphere.movingScale.z;
-  }
+// Physics starts from the orbits as they were at the last update.
+void SceneController::setAnimationMode(const SphereAnimationMode& mode) {
+  if (mode == SphereAnimationMode::Physics && animationMode != mode)
+    physics.start(data.spheres, data.animationTime);
+  animationMode = mode;
 }
 
 const SceneData& SceneController::sceneData() const { return data; }
-
-static AnimatedSphereData generateRandomAnimatedSphereData() noexcept {
-  std::random_device rd;
-  std::mt19937 engine(rd());
-
-  std::uniform_real_distribution<> positionDistribution(-0.75, 0.75);
-  glm::vec3 position{
-      positionDistribution(engine),
-      0.05,
-      positionDistribution(engine),
-  };
-
-  std::uniform_real_distribution<> movingScaleXDistribution(
-      0.05, 0.9 - std::abs(position.x));
-  std::uniform_real_distribution<> movingScaleYDistribution(
-      0.05, 0.9 - std::abs(position.y));
-  std::uniform_real_distribution<> movingScaleZDistribution(
-      0.05, 0.9 - std::abs(position.z));
-  glm::vec3 movingScale{
-      movingScaleXDistribution(engine),
-      0,
-      movingScaleZDistribution(engine),
-  };
-
-  std::uniform_real_distribution<float> cycleOffsetDistribution(0, 360);
-  float cycleOffset{cycleOffsetDistribution(engine)};
-
-  std::uniform_real_distribution colorDistribution(0.4, 0.95);
-  glm::vec3 color{
-      colorDistribution(engine),
-      colorDistribution(engine),
-      colorDistribution(engine),
-  };
-
-  std::uniform_real_distribution<float> speedDistribution(10, 50);
-  float speed{speedDistribution(engine)};
-
-  return {.originalPosition{position},
-          .movingScale{movingScale},
-          .cycleOffset{cycleOffset},
-          .sphereData{
-              .position{position},
-              .color{color},
-          },
-          .speed{speed}};
-}
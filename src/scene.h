@@ -1,7 +1,11 @@
 #pragma once
 #include <array>
-#include <random>
-#include <variant>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,59 +16,89 @@
 #include "grid.h"
 #include "light_source.h"
 #include "quad_tree.h"
+#include "render_queue.h"
+#include "scene_file.h"
 #include "sphere.h"
+#include "sphere_physics.h"
+#include "sphere_store.h"
+#include "static_batch.h"
+#include "uniform_blocks.h"
 #include "user_control.h"
 #include "wall.h"
 
-using StaticComponent =
-    std::variant<AxesComponent, GridComponent, LightSourceComponent>;
-using LighingComponent = std::variant<FloorComponent, WallComponent>;
-
-struct AnimatedSphereData {
-  glm::vec3 originalPosition;
-  glm::vec3 movingScale;
-  float cycleOffset;
-  SphereData sphereData;
-  float speed;
-};
-
+// animationTime is how far into the orbit cycle the spheres are, in seconds;
+// the orbit shader places them from it alone.
 struct SceneData {
-  std::vector<AnimatedSphereData> spheres;
+  SphereStore spheres;
   bool isBirdView;
+  float animationTime;
 };
 
+// The inside of a room on the xz plane.
+struct RoomBounds {
+  glm::vec2 min;
+  glm::vec2 max;
+};
+
+StaticLayout defaultStaticLayout();
+RoomBounds roomBounds(const StaticLayout& layout);
+
 class Scene {
 public:
-  Scene(const float& viewAspectRatio);
-  void render(const glm::mat4& view, const SceneData& data,
-              const glm::vec3& viewPosition,
-              std::vector<std::shared_ptr<QuadTreeNode>> treeLeafs) const;
-  void updateViewAspectRatio(const float& viewAspectRatio);
+  Scene(const StaticLayout& layout);
+  void render(const CameraUniformBuffer& cameraUniforms, const SceneData& data,
+              const QuadTree& quadTree) const;
+  void renderViews(const CameraUniformBuffer& cameraUniforms,
+                   const GLsizei& viewCount) const;
+  void update(const SceneData& data);
+  std::span<const CullStats> cullStats() const noexcept;
+  const LodStats& lodStats() const noexcept;
+  void setLodSettings(const LodSettings& settings) noexcept;
+  void setSphereRenderMode(const SphereRenderMode& mode) noexcept;
+  void setSphereCullMode(const SphereCullMode& mode) noexcept;
+  void setSphereAnimationMode(const SphereAnimationMode& mode) noexcept;
+  double sphereCullTime() const noexcept;
 
 private:
-  glm::mat4 proj{};
-  std::vector<StaticComponent> staticComponents{AxesComponent{},
-                                                GridComponent{}};
-  std::vector<LighingComponent> lightingComponents{};
-  std::vector<FloorComponent> cellingComponents{};
-  mutable std::vector<SphereComponent> sphereComponents{};
+  struct MaterialBatch {
+    StaticBatch batch;
+    bool isHiddenInBirdView;
+  };
+
+  AxesComponent axes{};
+  GridComponent grid{};
+  std::map<std::string, TextureProvider> textureProviders{};
+  std::vector<MaterialBatch> materialBatches{};
+  SphereComponent sphereComponent{};
+  std::vector<SphereInstance> sphereInstances{};
+  SphereAnimationMode sphereAnimationMode{SphereAnimationMode::Cpu};
+  bool areSphereOrbitsUploaded{};
   LightSourceComponent lightSource{glm::vec3{0.3f, 0.99f, 0.8f}};
+  LightUniformBuffer lightUniforms{};
+  mutable RenderQueue renderQueue{};
+  mutable std::vector<CullStats> frameCullStats{};
+  mutable LodStats frameLodStats{};
+  mutable double frameSphereCullTime{};
 
-  void addWalls();
-  void addFloor();
-  void addCeiling();
-  void renderSpheres(const glm::mat4& view, const glm::vec3& viewPosition,
-                     const std::vector<AnimatedSphereData>& data) const;
+  void enqueueSpheres() const;
+  void uploadSphereOrbits(const SceneData& data);
+  void enqueueStatic(const bool& isBirdView) const;
 };
 
+// Owns the scene data and moves the spheres.
 class SceneController {
 public:
-  SceneController();
+  SceneController(const uint64_t& seed, const size_t& sphereCount);
+  SceneController(const SceneFile& file);
+  void setAnimationMode(const SphereAnimationMode& mode);
   void updateSceneData(const bool& isBirdView, double currentTimestamp);
   const SceneData& sceneData() const;
 
 private:
   SceneData data{.isBirdView{false}};
+  SphereAnimationMode animationMode{SphereAnimationMode::Cpu};
+  SpherePhysics physics;
+  double lastTimestamp{};
 
-  float degreeCycleCounter{};
+  SceneController(const RoomBounds& room);
 };
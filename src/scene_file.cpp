@@ -0,0 +1,136 @@
+#include "scene_file.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+// Records are written and read as they are in memory, which is only the
+// file's byte order on a little-endian machine.
+static_assert(std::endian::native == std::endian::little);
+static_assert(sizeof(SceneMaterial) == 80);
+static_assert(sizeof(StaticInstance) == 80);
+static_assert(sizeof(SceneFileHeader) == 152);
+
+static constexpr std::array<std::vector<float> SphereStore::*,
+                            SceneFileHeader::sphereFieldCount>
+    sphereFields{&SphereStore::originX,     &SphereStore::originY,
+                 &SphereStore::originZ,     &SphereStore::scaleX,
+                 &SphereStore::scaleZ,      &SphereStore::cycleOffset,
+                 &SphereStore::speed,       &SphereStore::radius,
+                 &SphereStore::colorR,      &SphereStore::colorG,
+                 &SphereStore::colorB};
+
+static uint64_t alignSection(const uint64_t& offset) {
+  constexpr auto alignment{SceneFileHeader::sectionAlignment};
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Refuses files that are not scene files of this version, and sections
+// that are misaligned or run past the end of the file, before anything
+// reads them. Material paths must be terminated and instances must refer
+// to meshes and materials that exist.
+SceneFile::SceneFile(const std::string& fileName) : file{fileName} {
+  const auto bytes{file.bytes()};
+  if (bytes.size() < sizeof(SceneFileHeader))
+    throw std::runtime_error("Not a scene file: " + fileName);
+  header = reinterpret_cast<const SceneFileHeader*>(bytes.data());
+  if (header->magic != SceneFileHeader::expectedMagic)
+    throw std::runtime_error("Not a scene file: " + fileName);
+  if (header->version != SceneFileHeader::currentVersion ||
+      header->headerSize != sizeof(SceneFileHeader))
+    throw std::runtime_error("Unsupported scene file version: " + fileName);
+
+  const auto materials{section<SceneMaterial>(header->materialOffset,
+                                              header->materialCount)};
+  const auto instances{section<StaticInstance>(header->instanceOffset,
+                                               header->instanceCount)};
+  for (const auto& offset : header->sphereOffsets)
+    section<float>(offset, header->sphereCount);
+
+  for (const auto& material : materials)
+    if (material.texture.back() != '\0')
+      throw std::runtime_error("Unterminated texture path: " + fileName);
+  for (const auto& instance : instances)
+    if (instance.mesh > StaticMesh::Floor ||
+        instance.material >= materials.size())
+      throw std::runtime_error("Bad static instance: " + fileName);
+}
+
+uint64_t SceneFile::seed() const noexcept { return header->seed; }
+
+size_t SceneFile::sphereCount() const noexcept {
+  return static_cast<size_t>(header->sphereCount);
+}
+
+StaticLayout SceneFile::layout() const noexcept {
+  return {.materials{section<SceneMaterial>(header->materialOffset,
+                                            header->materialCount)},
+          .instances{section<StaticInstance>(header->instanceOffset,
+                                             header->instanceCount)}};
+}
+
+// Copies each field in one block and starts every sphere at its origin.
+void SceneFile::readSpheres(SphereStore& spheres) const {
+  const auto count{sphereCount()};
+  spheres.resize(count);
+  for (size_t field = 0; field < sphereFields.size(); field++) {
+    const auto values{
+        section<float>(header->sphereOffsets[field], header->sphereCount)};
+    std::memcpy((spheres.*sphereFields[field]).data(), values.data(),
+                values.size_bytes());
+  }
+  spheres.positionX = spheres.originX;
+  spheres.positionY = spheres.originY;
+  spheres.positionZ = spheres.originZ;
+}
+
+template <typename T>
+std::span<const T> SceneFile::section(const uint64_t& offset,
+                                      const uint64_t& count) const {
+  const auto bytes{file.bytes()};
+  if (offset % SceneFileHeader::sectionAlignment != 0 ||
+      offset > bytes.size() || count > (bytes.size() - offset) / sizeof(T))
+    throw std::runtime_error("Scene file section out of bounds");
+  return {reinterpret_cast<const T*>(bytes.data() + offset),
+          static_cast<size_t>(count)};
+}
+
+// Sections follow the header in the order they are listed in, with zeros
+// up to the alignment before each and at the end.
+void writeSceneFile(const std::string& fileName, const uint64_t& seed,
+                    const StaticLayout& layout, const SphereStore& spheres) {
+  SceneFileHeader header{.magic{SceneFileHeader::expectedMagic},
+                         .version{SceneFileHeader::currentVersion},
+                         .headerSize{sizeof(SceneFileHeader)},
+                         .seed{seed},
+                         .materialCount{layout.materials.size()},
+                         .instanceCount{layout.instances.size()},
+                         .sphereCount{spheres.size()}};
+  header.materialOffset = alignSection(sizeof(SceneFileHeader));
+  header.instanceOffset = alignSection(header.materialOffset +
+                                       layout.materials.size_bytes());
+  auto end{alignSection(header.instanceOffset +
+                        layout.instances.size_bytes())};
+  for (auto& offset : header.sphereOffsets) {
+    offset = end;
+    end = alignSection(offset + spheres.size() * sizeof(float));
+  }
+
+  std::ofstream stream{fileName, std::ios::binary | std::ios::trunc};
+  const auto write{[&](const uint64_t& offset, const void* data,
+                       const size_t& size) {
+    while (static_cast<uint64_t>(stream.tellp()) < offset) stream.put('\0');
+    stream.write(static_cast<const char*>(data),
+                 static_cast<std::streamsize>(size));
+  }};
+  write(0, &header, sizeof(header));
+  write(header.materialOffset, layout.materials.data(),
+        layout.materials.size_bytes());
+  write(header.instanceOffset, layout.instances.data(),
+        layout.instances.size_bytes());
+  for (size_t field = 0; field < sphereFields.size(); field++)
+    write(header.sphereOffsets[field], (spheres.*sphereFields[field]).data(),
+          spheres.size() * sizeof(float));
+  write(end, nullptr, 0);
+  if (!stream) throw std::runtime_error("Fail to write file: " + fileName);
+}
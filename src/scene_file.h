@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "mapped_file.h"
+#include "sphere_store.h"
+
+// The meshes the room is built of.
+enum class StaticMesh : uint32_t { Wall, Floor };
+
+// What static meshes are drawn with: the texture, as a null-terminated path,
+// and whether the bird view, which looks into the room from above, leaves
+// them out.
+struct SceneMaterial {
+  std::array<char, 64> texture;
+  uint32_t isHiddenInBirdView;
+  std::array<uint32_t, 3> reserved;
+};
+
+// One mesh of the room, placed by its model matrix.
+struct StaticInstance {
+  glm::mat4 model;
+  StaticMesh mesh;
+  uint32_t material;
+  std::array<uint32_t, 2> reserved;
+};
+
+// The static part of a scene, viewed wherever it is kept: instances index
+// into materials.
+struct StaticLayout {
+  std::span<const SceneMaterial> materials;
+  std::span<const StaticInstance> instances;
+};
+
+// A scene file starts with this header, followed by sections at the given
+// byte offsets, each aligned to sectionAlignment: the materials, the static
+// instances, and one array of sphereCount floats per sphere field, in the
+// order originX, originY, originZ, scaleX, scaleZ, cycleOffset, speed,
+// radius, colorR, colorG, colorB. Positions are not stored; spheres start at
+// their origins. Everything is little-endian, and the records are laid out
+// as the structs above, so a mapped file is used in place.
+//
+// A file of another version is refused rather than converted; any change
+// to the layout bumps version.
+struct SceneFileHeader {
+  static constexpr std::array<char, 8> expectedMagic{'M', 'P', 'S', 'C',
+                                                     'E', 'N', 'E', '\0'};
+  static constexpr uint32_t currentVersion{1};
+  static constexpr size_t sectionAlignment{64};
+  static constexpr size_t sphereFieldCount{11};
+
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t seed;
+  uint64_t materialCount;
+  uint64_t materialOffset;
+  uint64_t instanceCount;
+  uint64_t instanceOffset;
+  uint64_t sphereCount;
+  std::array<uint64_t, sphereFieldCount> sphereOffsets;
+};
+
+// A mapped scene file. The header and the bounds of every section are
+// checked when it is opened, and the layout it returns points into the
+// mapping, so it is valid as long as the file is.
+class SceneFile {
+public:
+  SceneFile(const std::string& fileName);
+  uint64_t seed() const noexcept;
+  size_t sphereCount() const noexcept;
+  StaticLayout layout() const noexcept;
+  void readSpheres(SphereStore& spheres) const;
+
+private:
+  MappedFile file;
+  const SceneFileHeader* header{};
+
+  template <typename T>
+  std::span<const T> section(const uint64_t& offset,
+                             const uint64_t& count) const;
+};
+
+void writeSceneFile(const std::string& fileName, const uint64_t& seed,
+                    const StaticLayout& layout, const SphereStore& spheres);
@@ -3,13 +3,19 @@
 static const std::string readShaderSourceFile(const std::string& filename);
 static void checkShaderCompile(const auto shader);
 static void checkShaderLink(const auto shaderProgram);
+static void bindUniformBlock(const GLuint& shaderProgram, const char* name,
+                             const GLuint& binding);
 
+// A non-empty header replaces the #version line of every source file, which
+// is how variants get a newer GLSL version and extra #defines.
 static const GLuint
-buildShaderProgram(const std::unordered_map<std::string, GLenum>& sourceFiles) {
+buildShaderProgram(const std::unordered_map<std::string, GLenum>& sourceFiles,
+                   const std::string& header) {
   const auto shaderProgram{glCreateProgram()};
   for (const auto& [sourceFile, shaderType] : sourceFiles) {
     const auto shader{glCreateShader(shaderType)};
-    const auto source = readShaderSourceFile(sourceFile);
+    auto source = readShaderSourceFile(sourceFile);
+    if (!header.empty()) source.replace(0, source.find('\n'), header);
     const auto sourceCStr = source.c_str();
     glShaderSource(shader, 1, &sourceCStr, nullptr);
 
@@ -22,37 +28,124 @@ buildShaderProgram(const std::unordered_map<std::string, GLenum>& sourceFiles) {
 
   glLinkProgram(shaderProgram);
   checkShaderLink(shaderProgram);
+  reflectUniforms(shaderProgram);
+  bindUniformBlock(shaderProgram, "Camera", cameraBlockBinding);
+  bindUniformBlock(shaderProgram, "Light", lightBlockBinding);
+  bindUniformBlock(shaderProgram, "Cull", cullBlockBinding);
   return shaderProgram;
 }
 
-const GLuint& BasicShaderProgramProvider::program() const {
-  if (glIsProgram(_program) == GL_TRUE) return _program;
+// Looks up every active uniform once, so setUniformToProgram never has to
+// query a location by name. Uniform block members are skipped, since they
+// are set through their buffer instead.
+void reflectUniforms(const GLuint& shaderProgram) {
+  if (uniformLocationTables.size() <= shaderProgram) {
+    uniformLocationTables.resize(shaderProgram + 1);
+    perDrawAttributeTables.resize(shaderProgram + 1);
+  }
+  auto& locations{uniformLocationTables[shaderProgram]};
+  locations.fill(-1);
+  perDrawAttributeTables[shaderProgram] =
+      glGetAttribLocation(shaderProgram, "model") ==
+      static_cast<GLint>(drawModelLocation);
+
+  GLint uniformCount{};
+  glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+  for (GLuint i = 0; i < static_cast<GLuint>(uniformCount); i++) {
+    std::array<GLchar, 256> name{};
+    GLsizei length{};
+    GLint size{};
+    GLenum type{};
+    glGetActiveUniform(shaderProgram, i, static_cast<GLsizei>(name.size()),
+                       &length, &size, &type, name.data());
+
+    std::string_view uniformName{name.data(), static_cast<size_t>(length)};
+    if (uniformName.ends_with("[0]")) uniformName.remove_suffix(3);
+
+    const auto entry{std::find(uniformNames.begin(), uniformNames.end(),
+                               uniformName)};
+    if (entry != uniformNames.end())
+      locations[entry - uniformNames.begin()] =
+          glGetUniformLocation(shaderProgram, name.data());
+  }
+}
+
+ShaderProgramProvider::ShaderProgramProvider(
+    std::string vertexShaderFile, std::string fragmentShaderFile,
+    const std::vector<std::string>& fragmentLibraries)
+    : sourceFiles{{vertexShaderFile, GL_VERTEX_SHADER},
+                  {fragmentShaderFile, GL_FRAGMENT_SHADER}} {
+  for (const auto& library : fragmentLibraries)
+    sourceFiles.emplace(library, GL_FRAGMENT_SHADER);
+};
+
+const GLuint& ShaderProgramProvider::program() const {
+  if (_program != 0) [[likely]] return _program;
 
-  _program = buildShaderProgram(
-      {{"basic.vert", GL_VERTEX_SHADER}, {"basic.frag", GL_FRAGMENT_SHADER}});
+  _program = buildShaderProgram(sourceFiles, "");
 
   return _program;
 }
 
-const GLuint& LightingShaderProgramProvider::program() const {
-  if (glIsProgram(_program) == GL_TRUE) return _program;
+const GLuint& ShaderProgramProvider::multiViewProgram() const {
+  if (_multiViewProgram != 0) [[likely]] return _multiViewProgram;
 
-  _program = buildShaderProgram({{"lighting.vert", GL_VERTEX_SHADER},
-                                 {"lighting.frag", GL_FRAGMENT_SHADER}});
+  _multiViewProgram =
+      buildShaderProgram(sourceFiles, "#version 410 core\n#define MULTI_VIEW");
 
-  return _program;
+  return _multiViewProgram;
+}
+
+const GLuint&
+ShaderProgramProvider::perDrawProgram(const bool& isMultiView) const {
+  auto& program{perDrawPrograms[isMultiView]};
+  if (program != 0) [[likely]] return program;
+
+  program = buildShaderProgram(
+      sourceFiles,
+      isMultiView ? "#version 410 core\n#define MULTI_VIEW\n#define PER_DRAW"
+                  : "#version 330 core\n#define PER_DRAW");
+
+  return program;
 }
 
-const GLuint& TextureLightingShaderProgramProvider::program() const {
-  if (glIsProgram(_program) == GL_TRUE) return _program;
+ComputeShaderProgramProvider::ComputeShaderProgramProvider(
+    std::string computeShaderFile)
+    : sourceFiles{{computeShaderFile, GL_COMPUTE_SHADER}} {};
 
-  _program =
-      buildShaderProgram({{"texture_lighting.vert", GL_VERTEX_SHADER},
-                          {"texture_lighting.frag", GL_FRAGMENT_SHADER}});
+const GLuint& ComputeShaderProgramProvider::program() const {
+  if (_program != 0) [[likely]] return _program;
+
+  _program = buildShaderProgram(sourceFiles, "");
 
   return _program;
 }
 
+BasicShaderProgramProvider::BasicShaderProgramProvider()
+    : ShaderProgramProvider("basic.vert", "basic.frag"){};
+
+LightingShaderProgramProvider::LightingShaderProgramProvider()
+    : ShaderProgramProvider("lighting.vert", "lighting.frag", {"phong.frag"}){};
+
+TextureLightingShaderProgramProvider::TextureLightingShaderProgramProvider()
+    : ShaderProgramProvider("texture_lighting.vert", "texture_lighting.frag",
+                            {"phong.frag"}){};
+
+InstancedLightingShaderProgramProvider::InstancedLightingShaderProgramProvider()
+    : ShaderProgramProvider("instanced_lighting.vert", "lighting.frag",
+                            {"phong.frag"}){};
+
+SphereImpostorShaderProgramProvider::SphereImpostorShaderProgramProvider()
+    : ShaderProgramProvider("sphere_impostor.vert", "sphere_impostor.frag",
+                            {"phong.frag"}){};
+
+SphereOrbitShaderProgramProvider::SphereOrbitShaderProgramProvider()
+    : ShaderProgramProvider("sphere_orbit.vert", "lighting.frag",
+                            {"phong.frag"}){};
+
+SphereCullShaderProgramProvider::SphereCullShaderProgramProvider()
+    : ComputeShaderProgramProvider("sphere_cull.comp"){};
+
 static const std::string readShaderSourceFile(const std::string& filename) {
   const auto sourcePath = std::filesystem::path("src") / "shaders";
   std::ifstream shaderFile(sourcePath / filename);
@@ -88,3 +181,10 @@ static void checkShaderLink(const auto shaderProgram) {
     throw std::runtime_error(infoLog.data());
   }
 }
+
+static void bindUniformBlock(const GLuint& shaderProgram, const char* name,
+                             const GLuint& binding) {
+  const auto blockIndex{glGetUniformBlockIndex(shaderProgram, name)};
+  if (blockIndex != GL_INVALID_INDEX)
+    glUniformBlockBinding(shaderProgram, blockIndex, binding);
+}
@@ -1,60 +1,167 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "render_state.h"
+
+// Uniform block bindings shared by every program.
+static constexpr GLuint cameraBlockBinding{0};
+static constexpr GLuint lightBlockBinding{1};
+static constexpr GLuint cullBlockBinding{2};
+
+// Attribute locations of the model matrix, which takes four of them, and the
+// color in programs built with PER_DRAW.
+static constexpr GLuint drawModelLocation{8};
+static constexpr GLuint drawColorLocation{12};
+
 static const GLuint
-buildShaderProgram(const std::unordered_map<std::string, GLenum>& sourceFiles);
+buildShaderProgram(const std::unordered_map<std::string, GLenum>& sourceFiles,
+                   const std::string& header);
 
-class BasicShaderProgramProvider {
+// Builds a program lazily from a vertex/fragment pair, plus any fragment
+// libraries such as phong.frag that are compiled separately and linked in.
+// The multi-view variant is the same source compiled with MULTI_VIEW defined;
+// it is only built on first use, since it needs
+// GL_ARB_shader_viewport_layer_array. The per-draw variants also define
+// PER_DRAW, which reads the model matrix and color from instanced attributes
+// instead of uniforms, for draws submitted through multi-draw indirect.
+class ShaderProgramProvider {
 public:
+  ShaderProgramProvider(std::string vertexShaderFile,
+                        std::string fragmentShaderFile,
+                        const std::vector<std::string>& fragmentLibraries = {});
   const GLuint& program() const;
+  const GLuint& multiViewProgram() const;
+  const GLuint& perDrawProgram(const bool& isMultiView) const;
 
 private:
+  std::unordered_map<std::string, GLenum> sourceFiles{};
   mutable GLuint _program{};
+  mutable GLuint _multiViewProgram{};
+  mutable std::array<GLuint, 2> perDrawPrograms{};
 };
 
-class LightingShaderProgramProvider {
+// Builds a program lazily from a single compute shader. Compute shaders need
+// GL 4.3, so callers check for it before asking for the program.
+class ComputeShaderProgramProvider {
 public:
+  explicit ComputeShaderProgramProvider(std::string computeShaderFile);
   const GLuint& program() const;
 
 private:
+  std::unordered_map<std::string, GLenum> sourceFiles{};
   mutable GLuint _program{};
 };
 
-class TextureLightingShaderProgramProvider {
+class BasicShaderProgramProvider : public ShaderProgramProvider {
 public:
-  const GLuint& program() const;
+  BasicShaderProgramProvider();
+};
 
-private:
-  mutable GLuint _program{};
+class LightingShaderProgramProvider : public ShaderProgramProvider {
+public:
+  LightingShaderProgramProvider();
+};
+
+class TextureLightingShaderProgramProvider : public ShaderProgramProvider {
+public:
+  TextureLightingShaderProgramProvider();
+};
+
+class InstancedLightingShaderProgramProvider : public ShaderProgramProvider {
+public:
+  InstancedLightingShaderProgramProvider();
+};
+
+class SphereImpostorShaderProgramProvider : public ShaderProgramProvider {
+public:
+  SphereImpostorShaderProgramProvider();
+};
+
+class SphereOrbitShaderProgramProvider : public ShaderProgramProvider {
+public:
+  SphereOrbitShaderProgramProvider();
+};
+
+class SphereCullShaderProgramProvider : public ComputeShaderProgramProvider {
+public:
+  SphereCullShaderProgramProvider();
+};
+
+// Every uniform name declared by the shaders in src/shaders; a UniformKey is
+// an index into this table. Adding a uniform to a shader means adding its
+// name here, or the key for it will not compile.
+inline constexpr std::array<std::string_view, 5> uniformNames{
+    "model", "color", "viewCount", "tex", "time"};
+
+// Uniform name resolved to its table index at compile time, so a string
+// literal passed to setUniformToProgram costs nothing at run time.
+struct UniformKey {
+  size_t index{};
+
+  template <size_t N> consteval UniformKey(const char (&name)[N]) {
+    const std::string_view key{name, N - 1};
+    while (index < uniformNames.size() && uniformNames[index] != key)
+      index++;
+    if (index == uniformNames.size())
+      throw std::invalid_argument("Unknown uniform name");
+  }
 };
 
+using UniformLocations = std::array<GLint, uniformNames.size()>;
+
+// Location tables indexed by program name, filled by reflectUniforms right
+// after a program is linked. Uniforms a program does not use stay at -1,
+// which glUniform* ignores.
+inline std::vector<UniformLocations> uniformLocationTables{};
+
+// Whether a program reads the per-draw attributes, indexed by program name
+// and filled by reflectUniforms along with the location tables.
+inline std::vector<uint8_t> perDrawAttributeTables{};
+
+void reflectUniforms(const GLuint& shaderProgram);
+
+inline bool readsPerDrawAttributes(const GLuint& shaderProgram) {
+  return perDrawAttributeTables[shaderProgram] != 0;
+}
+
+inline GLint uniformLocation(const GLuint& shaderProgram,
+                             const UniformKey& key) {
+  return uniformLocationTables[shaderProgram][key.index];
+}
+
 template <typename T>
 concept UniformAcceptable =
     std::is_same_v<T, glm::mat4> || std::is_same_v<T, glm::vec4> ||
-    std::is_same_v<T, glm::vec3> || std::is_same_v<T, GLfloat>;
+    std::is_same_v<T, glm::vec3> || std::is_same_v<T, GLfloat> ||
+    std::is_same_v<T, GLint>;
 
+// Sets a uniform of the program currently in use; the caller must have bound
+// shaderProgram with RenderState::useProgram.
 template <UniformAcceptable T>
-void setUniformToProgram(const GLuint& shaderProgram, const std::string& name,
+void setUniformToProgram(const GLuint& shaderProgram, const UniformKey& key,
                          const T& data) {
-  glUseProgram(shaderProgram);
+  const auto location{uniformLocation(shaderProgram, key)};
   if constexpr (std::is_same_v<T, glm::mat4>) {
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, name.c_str()), 1,
-                       GL_FALSE, glm::value_ptr(data));
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(data));
   } else if constexpr (std::is_same_v<T, glm::vec4>) {
-    glUniform4fv(glGetUniformLocation(shaderProgram, name.c_str()), 1,
-                 glm::value_ptr(data));
+    glUniform4fv(location, 1, glm::value_ptr(data));
   } else if constexpr (std::is_same_v<T, glm::vec3>) {
-    glUniform3fv(glGetUniformLocation(shaderProgram, name.c_str()), 1,
-                 glm::value_ptr(data));
+    glUniform3fv(location, 1, glm::value_ptr(data));
   } else if constexpr (std::is_same_v<T, GLfloat>) {
-    glUniform1f(glGetUniformLocation(shaderProgram, name.c_str()), data);
+    glUniform1f(location, data);
+  } else if constexpr (std::is_same_v<T, GLint>) {
+    glUniform1i(location, data);
   }
 }
@@ -2,8 +2,16 @@
 
 out vec4 oColor;
 
+#ifdef PER_DRAW
+flat in vec4 fragmentColor;
+#else
 uniform vec4 color;
+#endif
 
 void main() {
+#ifdef PER_DRAW
+  oColor = fragmentColor;
+#else
   oColor = color;
+#endif
 }
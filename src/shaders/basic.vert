@@ -1,11 +1,38 @@
 #version 330 core
 
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
 layout (location = 0) in vec3 iPosition;
 
+// Drawn through multi-draw indirect, the model matrix and color come with
+// each draw as instanced attributes the draw's base instance points at.
+#ifdef PER_DRAW
+layout (location = 8) in mat4 model;
+layout (location = 12) in vec4 drawColor;
+flat out vec4 fragmentColor;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+#endif
+
+layout (std140) uniform Camera {
+  mat4 views[16];
+  mat4 projs[16];
+  vec4 viewPositions[16];
+};
 
 void main() {
-  gl_Position = proj * view * model * vec4(iPosition.xyz, 1.0);
+#ifdef MULTI_VIEW
+  // One instance per view; each instance lands in its own viewport.
+  int viewIndex = gl_InstanceID;
+  gl_ViewportIndex = viewIndex;
+#else
+  int viewIndex = 0;
+#endif
+  gl_Position = projs[viewIndex] * views[viewIndex] * model *
+                vec4(iPosition.xyz, 1.0);
+#ifdef PER_DRAW
+  fragmentColor = drawColor;
+#endif
 }
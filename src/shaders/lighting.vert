@@ -1,17 +1,42 @@
 #version 330 core
 
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
 layout (location = 0) in vec3 iPosition;
 layout (location = 1) in vec3 iNormal;
 
 out vec3 fragmentNormal;
 out vec3 fragmentPosition;
+out vec4 fragmentColor;
 
+#ifdef PER_DRAW
+layout (location = 8) in mat4 model;
+layout (location = 12) in vec4 color;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+uniform vec4 color;
+#endif
+
+layout (std140) uniform Camera {
+  mat4 views[16];
+  mat4 projs[16];
+  vec4 viewPositions[16];
+};
+flat out vec3 viewPosition;
 
 void main() {
-  gl_Position = proj * view * model * vec4(iPosition.xyz, 1.0);
+#ifdef MULTI_VIEW
+  int viewIndex = gl_InstanceID;
+  gl_ViewportIndex = viewIndex;
+#else
+  int viewIndex = 0;
+#endif
+  viewPosition = viewPositions[viewIndex].xyz;
+  gl_Position = projs[viewIndex] * views[viewIndex] * model *
+                vec4(iPosition.xyz, 1.0);
   fragmentNormal = vec3(model * vec4(iNormal, 0.0));
   fragmentPosition = vec3(model * vec4(iPosition, 1.0));
+  fragmentColor = color;
 }
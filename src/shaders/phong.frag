@@ -0,0 +1,33 @@
+#version 330 core
+
+layout (std140) uniform Light {
+  vec3 lightPosition;
+  float luminousIntensity;
+  vec3 lightAmbient;
+  vec3 lightDiffuse;
+  vec3 lightSpecular;
+};
+
+// Phong shading of a surface point by the point light, linked into every
+// lighting program as a separate fragment shader object.
+vec3 calcPointLight(vec3 albedo, vec3 position, vec3 normal,
+                    vec3 viewDirection) {
+  // diffuse
+  vec3 lightDirection = normalize(lightPosition - position);
+  float normalDifference = max(dot(normal, lightDirection), 0.0);
+  vec3 diffuse = albedo * normalDifference * lightDiffuse;
+
+  // specular
+  vec3 reflectDireciton = reflect(-lightDirection, normal);
+  float shininess = pow(max(dot(viewDirection, reflectDireciton), 0.0), 20);
+  vec3 specular = albedo * shininess * lightSpecular;
+
+  // ambient
+  vec3 ambient = albedo * lightAmbient;
+
+  vec3 positionDifference = lightPosition - position;
+  float distance = length(positionDifference);
+  float illumination = luminousIntensity / (1 + 0.1 * distance + 0.05 * pow(distance, 2));
+
+  return illumination * (specular + ambient + diffuse);
+}
@@ -0,0 +1,46 @@
+#version 330 core
+
+#ifdef GL_ARB_conservative_depth
+#extension GL_ARB_conservative_depth : enable
+// The surface is never in front of the quad, so early depth tests still hold.
+layout (depth_greater) out float gl_FragDepth;
+#endif
+
+in vec3 fragmentPosition;
+flat in vec4 sphere;
+flat in vec4 fragmentColor;
+flat in vec3 viewPosition;
+flat in vec3 eyePosition;
+flat in int viewIndex;
+
+out vec4 oColor;
+
+layout (std140) uniform Camera {
+  mat4 views[16];
+  mat4 projs[16];
+  vec4 viewPositions[16];
+};
+
+vec3 calcPointLight(vec3 albedo, vec3 position, vec3 normal,
+                    vec3 viewDirection);
+
+void main() {
+  // Nearest intersection of the eye ray through this fragment with the
+  // sphere; rays that miss fall in the corners of the quad.
+  vec3 rayDirection = normalize(fragmentPosition - eyePosition);
+  vec3 toCenter = sphere.xyz - eyePosition;
+  float b = dot(rayDirection, toCenter);
+  float discriminant = b * b - dot(toCenter, toCenter) + sphere.w * sphere.w;
+  if (discriminant < 0.0) discard;
+
+  vec3 position = eyePosition + rayDirection * (b - sqrt(discriminant));
+  vec3 normal = (position - sphere.xyz) / sphere.w;
+
+  vec4 clipPosition = projs[viewIndex] * views[viewIndex] * vec4(position, 1.0);
+  gl_FragDepth = clipPosition.z / clipPosition.w * 0.5 + 0.5;
+
+  vec3 viewDirection = normalize(viewPosition - position);
+  oColor = vec4(calcPointLight(vec3(fragmentColor), position, normal,
+                               viewDirection),
+                fragmentColor.a);
+}
@@ -0,0 +1,61 @@
+#version 330 core
+
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
+layout (location = 0) in vec2 iCorner;
+layout (location = 2) in vec4 iInstancePositionScale;
+layout (location = 3) in vec4 iInstanceColor;
+
+out vec3 fragmentPosition;
+flat out vec4 sphere;
+flat out vec4 fragmentColor;
+flat out vec3 viewPosition;
+flat out vec3 eyePosition;
+flat out int viewIndex;
+
+layout (std140) uniform Camera {
+  mat4 views[16];
+  mat4 projs[16];
+  vec4 viewPositions[16];
+};
+
+#ifdef MULTI_VIEW
+uniform int viewCount;
+#endif
+
+void main() {
+#ifdef MULTI_VIEW
+  // Instances are laid out view-major within each sphere, and the instance
+  // attributes advance once every viewCount instances.
+  viewIndex = gl_InstanceID % viewCount;
+  gl_ViewportIndex = viewIndex;
+#else
+  viewIndex = 0;
+#endif
+  viewPosition = viewPositions[viewIndex].xyz;
+  sphere = iInstancePositionScale;
+  fragmentColor = iInstanceColor;
+
+  // viewPosition only feeds the lighting, and the bird view sets it apart
+  // from the camera, so rays start from the eye of the view matrix.
+  mat4 view = views[viewIndex];
+  eyePosition = -(transpose(mat3(view)) * view[3].xyz);
+
+  // The quad faces the eye from where the sphere's front would touch it, and
+  // is just large enough there to cover the cone of the sphere's silhouette.
+  vec3 toCenter = sphere.xyz - eyePosition;
+  float distance = length(toCenter);
+  vec3 forward = toCenter / distance;
+  vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+  vec3 right = normalize(cross(forward, cameraUp));
+  vec3 up = cross(right, forward);
+
+  float front = max(distance - sphere.w, 0.0);
+  float halfSize = front * sphere.w /
+                   sqrt(max(distance * distance - sphere.w * sphere.w, 1e-8));
+  fragmentPosition = eyePosition + forward * front +
+                     (right * iCorner.x + up * iCorner.y) * halfSize;
+  gl_Position = projs[viewIndex] * view * vec4(fragmentPosition, 1.0);
+}
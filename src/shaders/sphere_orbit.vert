@@ -0,0 +1,54 @@
+#version 330 core
+
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
+layout (location = 0) in vec3 iPosition;
+layout (location = 1) in vec3 iNormal;
+layout (location = 2) in vec4 iInstancePositionScale;
+layout (location = 3) in vec4 iInstanceColor;
+layout (location = 4) in vec4 iInstanceOrbit;
+
+out vec3 fragmentNormal;
+out vec3 fragmentPosition;
+out vec4 fragmentColor;
+
+layout (std140) uniform Camera {
+  mat4 views[16];
+  mat4 projs[16];
+  vec4 viewPositions[16];
+};
+flat out vec3 viewPosition;
+
+#ifdef MULTI_VIEW
+uniform int viewCount;
+#endif
+
+// Seconds into the orbit cycle, as SceneData::animationTime.
+uniform float time;
+
+// The same motion as animateSpheres: every sphere goes around an ellipse in
+// the xz plane at its own speed, starting from its own phase.
+
+void main() {
+#ifdef MULTI_VIEW
+  // Instances are laid out view-major within each sphere, and the instance
+  // attributes advance once every viewCount instances.
+  int viewIndex = gl_InstanceID % viewCount;
+  gl_ViewportIndex = viewIndex;
+#else
+  int viewIndex = 0;
+#endif
+  float angle = radians(time * iInstanceOrbit.w + iInstanceOrbit.z);
+  vec3 center = iInstancePositionScale.xyz +
+                vec3(sin(angle) * iInstanceOrbit.x, 0.0,
+                     cos(angle) * iInstanceOrbit.y);
+
+  viewPosition = viewPositions[viewIndex].xyz;
+  vec3 worldPosition = center + iPosition * iInstancePositionScale.w;
+  gl_Position = projs[viewIndex] * views[viewIndex] * vec4(worldPosition, 1.0);
+  fragmentNormal = iNormal;
+  fragmentPosition = worldPosition;
+  fragmentColor = iInstanceColor;
+}
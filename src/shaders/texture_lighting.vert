@@ -1,5 +1,9 @@
 #version 330 core
 
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
 layout (location = 0) in vec3 iPosition;
 layout (location = 1) in vec2 iTextureCoord;
 layout (location = 2) in vec3 iNormal;
@@ -8,13 +12,30 @@ out vec2 textureCoord;
 out vec3 fragmentNormal;
 out vec3 fragmentPosition;
 
+#ifdef PER_DRAW
+layout (location = 8) in mat4 model;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+#endif
+
+layout (std140) uniform Camera {
+  mat4 views[16];
+  mat4 projs[16];
+  vec4 viewPositions[16];
+};
+flat out vec3 viewPosition;
 
 void main() {
+#ifdef MULTI_VIEW
+  int viewIndex = gl_InstanceID;
+  gl_ViewportIndex = viewIndex;
+#else
+  int viewIndex = 0;
+#endif
+  viewPosition = viewPositions[viewIndex].xyz;
   textureCoord = iTextureCoord;
-  gl_Position = proj * view * model * vec4(iPosition.xyz, 1.0);
+  gl_Position = projs[viewIndex] * views[viewIndex] * model *
+                vec4(iPosition.xyz, 1.0);
   fragmentNormal = vec3(model * vec4(iNormal, 0.0));
   fragmentPosition = vec3(model * vec4(iPosition, 1.0));
 }
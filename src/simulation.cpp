@@ -0,0 +1,100 @@
+#include "simulation.h"
+
+// Times are in the render thread's clock, which starts at currentTime; the
+// simulation reads the same GLFW timer shifted by the difference.
+SimulationThread::SimulationThread(SceneController& controller,
+                                   const double& timestep,
+                                   const double& currentTime)
+    : controller{controller}, timestep{timestep},
+      epoch{glfwGetTime() - currentTime},
+      snapshots{SceneSnapshot{.data{controller.sceneData()},
+                              .timestamp{currentTime},
+                              .publishedAt{currentTime}}} {
+  thread = std::jthread{[this](std::stop_token stopToken) { run(stopToken); }};
+}
+
+void SimulationThread::setAnimationMode(
+    const SphereAnimationMode& mode) noexcept {
+  animationMode = mode;
+}
+
+// Only the positions and the animation time change between ticks; the rest
+// of the scene is copied once, when data does not hold these spheres yet.
+// With the orbit shader the positions are left alone, as on the simulation
+// side.
+void SimulationThread::interpolate(SceneData& data,
+                                   const double& currentTime) {
+  const auto& snapshot{snapshots.read()};
+  const auto& spheres{snapshot.data.spheres};
+  if (data.spheres.size() != spheres.size()) {
+    const auto isBirdView{data.isBirdView};
+    data = snapshot.data;
+    data.isBirdView = isBirdView;
+  }
+
+  const auto alpha{static_cast<float>(
+      std::clamp((currentTime - snapshot.timestamp) / timestep, 0.0, 1.0))};
+  data.animationTime = static_cast<float>(std::fmod(
+      snapshot.timestamp - timestep * (1.0f - alpha), 360.0));
+  if (animationMode == SphereAnimationMode::Shader ||
+      snapshot.previousX.size() != spheres.size())
+    return;
+
+  const auto blend{[&](std::vector<float>& position,
+                       const std::vector<float>& previous,
+                       const std::vector<float>& current) {
+    for (size_t i = 0; i < current.size(); i++)
+      position[i] = previous[i] + (current[i] - previous[i]) * alpha;
+  }};
+  blend(data.spheres.positionX, snapshot.previousX, spheres.positionX);
+  blend(data.spheres.positionY, snapshot.previousY, spheres.positionY);
+  blend(data.spheres.positionZ, snapshot.previousZ, spheres.positionZ);
+}
+
+SimulationStats
+SimulationThread::stats(const double& currentTime) const noexcept {
+  const auto& snapshot{snapshots.front()};
+  return {.tickSeconds{snapshot.tickSeconds},
+          .snapshotAge{currentTime - snapshot.publishedAt}};
+}
+
+double SimulationThread::now() const { return glfwGetTime() - epoch; }
+
+// Sleeps until the wall clock reaches the next tick, simulates the scene at
+// exactly that time and publishes it. The bird view flag is the render
+// thread's, so the snapshots leave it unset.
+void SimulationThread::run(std::stop_token stopToken) {
+  auto timestamp{now()};
+  while (!stopToken.stop_requested()) {
+    for (auto wait{timestamp - now()}; wait > 0.0; wait = timestamp - now()) {
+      std::this_thread::sleep_for(std::chrono::duration<double>{wait});
+      if (stopToken.stop_requested()) return;
+    }
+
+    const auto start{now()};
+    const auto mode{animationMode.load()};
+    auto& snapshot{snapshots.back()};
+    const auto& spheres{controller.sceneData().spheres};
+    if (mode != SphereAnimationMode::Shader) {
+      snapshot.previousX = spheres.positionX;
+      snapshot.previousY = spheres.positionY;
+      snapshot.previousZ = spheres.positionZ;
+    }
+
+    controller.setAnimationMode(mode);
+    controller.updateSceneData(false, timestamp);
+    if (mode != SphereAnimationMode::Shader) {
+      snapshot.data.spheres.positionX = spheres.positionX;
+      snapshot.data.spheres.positionY = spheres.positionY;
+      snapshot.data.spheres.positionZ = spheres.positionZ;
+    }
+    snapshot.data.animationTime = controller.sceneData().animationTime;
+    snapshot.timestamp = timestamp;
+    snapshot.tickSeconds = now() - start;
+    snapshot.publishedAt = now();
+    snapshots.publish();
+
+    timestamp += timestep;
+    if (now() - timestamp > maxLagTicks * timestep) timestamp = now();
+  }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#include "scene.h"
+#include "triple_buffer.h"
+
+// One tick of the simulation: the scene after it, the sphere positions
+// before it, the time it simulates, when it was published and how long it
+// took to compute, the last two in wall-clock seconds.
+struct SceneSnapshot {
+  SceneData data;
+  std::vector<float> previousX;
+  std::vector<float> previousY;
+  std::vector<float> previousZ;
+  double timestamp;
+  double publishedAt;
+  double tickSeconds;
+};
+
+// How long the latest tick took to simulate and how old its snapshot was
+// when the frame picked it up.
+struct SimulationStats {
+  double tickSeconds;
+  double snapshotAge;
+};
+
+// Runs a SceneController at a fixed timestep on its own thread, which owns
+// the controller until the simulation is destroyed. Every tick is published
+// as a snapshot through a triple buffer, so the render thread takes the
+// latest one without blocking and the simulation never waits for a frame.
+//
+// Frames are drawn one tick behind: interpolate blends the positions before
+// and after the latest tick by how far the frame is past it. A simulation
+// that falls more than maxLagTicks behind skips ahead instead of catching
+// up.
+class SimulationThread {
+public:
+  static constexpr int maxLagTicks{4};
+
+  SimulationThread(SceneController& controller, const double& timestep,
+                   const double& currentTime);
+  void setAnimationMode(const SphereAnimationMode& mode) noexcept;
+  void interpolate(SceneData& data, const double& currentTime);
+  SimulationStats stats(const double& currentTime) const noexcept;
+
+private:
+  SceneController& controller;
+  double timestep{};
+  double epoch{};
+  std::atomic<SphereAnimationMode> animationMode{SphereAnimationMode::Cpu};
+  TripleBuffer<SceneSnapshot> snapshots;
+  std::jthread thread{};
+
+  double now() const;
+  void run(std::stop_token stopToken);
+};
@@ -1,168 +1,347 @@
 #include "sphere.h"
 
-static const std::vector<glm::vec3>
-subdivideTriangle(const std::array<glm::vec3, 3>& triangle, const size_t& step);
+const GLuint& SphereVaoProvider::vao(const SphereLod& level) const {
+  static auto _ = std::invoke([this] {
+    glGenVertexArrays(static_cast<GLsizei>(_vaos.size()), _vaos.data());
+    glGenBuffers(static_cast<GLsizei>(_instanceVbos.size()),
+                 _instanceVbos.data());
+
+    for (size_t i = 0; i < _vaos.size(); i++) {
+      RenderState::bindVertexArray(_vaos[i]);
+      meshProvider.attach();
+
+      glBindBuffer(GL_ARRAY_BUFFER, _instanceVbos[i]);
+      glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                            (GLvoid*)offsetof(SphereInstance, positionRadius));
+      glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                            (GLvoid*)offsetof(SphereInstance, color));
+
+      glEnableVertexAttribArray(2);
+      glEnableVertexAttribArray(3);
+      glVertexAttribDivisor(2, 1);
+      glVertexAttribDivisor(3, 1);
+    }
+    return 0;
+  });
+  return _vaos[static_cast<size_t>(level)];
+}
 
-const GLuint& SphereVaoProvider::vao() const {
+const GLuint& SphereVaoProvider::instanceVbo(const SphereLod& level) const {
+  vao(level);
+  return _instanceVbos[static_cast<size_t>(level)];
+}
+
+const GLuint& SphereImpostorVaoProvider::vao() const {
   static auto _ = std::invoke([this] {
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    RenderState::bindVertexArray(_vao);
 
     GLuint vbo{};
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3),
-                 vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
-                          static_cast<void*>(0));
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+    const std::array<glm::vec2, 4> corners{
+        {{-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f}, {1.0f, 1.0f}}};
+    glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(glm::vec2),
+                 corners.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2),
                           static_cast<void*>(0));
-
     glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
+
+    glGenBuffers(1, &_instanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVbo);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                          (GLvoid*)offsetof(SphereInstance, positionRadius));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                          (GLvoid*)offsetof(SphereInstance, color));
+
+    glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribDivisor(3, 1);
     return 0;
   });
   return _vao;
 }
 
-SphereComponent::SphereComponent() {
-  setUniformToProgram(shaderProgramProvider.program(), "lightAmbient",
-                      glm::vec3{0.2f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightDiffuse",
-                      glm::vec3{1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightSpecular",
-                      glm::vec3{1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "luminousIntensity",
-                      GLfloat(1));
-};
+const GLuint& SphereImpostorVaoProvider::instanceVbo() const {
+  vao();
+  return _instanceVbo;
+}
 
-SphereComponent::SphereComponent(AnimatedSphereDataV2 data) : data(data) {
-  setUniformToProgram(shaderProgramProvider.program(), "lightAmbient",
-                      glm::vec3{0.2f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightDiffuse",
-                      glm::vec3{1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "lightSpecular",
-                      glm::vec3{1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "luminousIntensity",
-                      GLfloat(1));
-};
+const GLuint& SphereGpuCullVaoProvider::vao() const {
+  static auto _ = std::invoke([this] {
+    glGenVertexArrays(1, &_vao);
+    RenderState::bindVertexArray(_vao);
+    meshProvider.attach();
 
-void SphereComponent::render(const glm::mat4& view, const glm::mat4& proj,
-                             const SphereData& data,
-                             const glm::vec3& viewPosition,
-                             const glm::vec3& lightPosition) const {
-  glBindVertexArray(vaoProvider.vao());
-  glUseProgram(shaderProgramProvider.program());
-
-  glm::mat4 model{1.0f};
-  model = glm::translate(model, data.position);
-  model = glm::scale(model, glm::vec3{0.05f});
-
-  setUniformToProgram(shaderProgramProvider.program(), "model", model);
-  setUniformToProgram(shaderProgramProvider.program(), "view", view);
-  setUniformToProgram(shaderProgramProvider.program(), "proj", proj);
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{data.color, 1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "viewPosition",
-                      viewPosition);
-  setUniformToProgram(shaderProgramProvider.program(), "lightPosition",
-                      lightPosition);
-
-  glDrawArrays(GL_TRIANGLES, 0,
-               static_cast<GLsizei>(vaoProvider.vertices.size()));
-};
+    glGenBuffers(1, &_culledInstanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _culledInstanceVbo);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                          (GLvoid*)offsetof(SphereInstance, positionRadius));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                          (GLvoid*)offsetof(SphereInstance, color));
 
-void SphereComponent::render(const glm::mat4& view, const glm::mat4& proj,
-                             glm::vec3& viewPosition, glm::vec3& lightPosition,
-                             UserControlData& userData) const {
-  glBindVertexArray(vaoProvider.vao());
-  glUseProgram(shaderProgramProvider.program());
-
-  glm::mat4 model{1.0f};
-  model = glm::translate(model, data.sphereData.position);
-  model = glm::scale(model, glm::vec3{0.05f});
-
-  setUniformToProgram(shaderProgramProvider.program(), "model", model);
-  setUniformToProgram(shaderProgramProvider.program(), "view", view);
-  setUniformToProgram(shaderProgramProvider.program(), "proj", proj);
-  setUniformToProgram(shaderProgramProvider.program(), "color",
-                      glm::vec4{data.sphereData.color, 1.0f});
-  setUniformToProgram(shaderProgramProvider.program(), "viewPosition",
-                      viewPosition);
-  setUniformToProgram(shaderProgramProvider.program(), "lightPosition",
-                      lightPosition);
-
-  glDrawArrays(GL_TRIANGLES, 0,
-               static_cast<GLsizei>(vaoProvider.vertices.size()));
-};
+    glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribDivisor(3, 1);
+    return 0;
+  });
+  return _vao;
+}
 
-void SphereComponent::updatePosition(double& currentTimestamp) {
-  float degreeCycleCounter =
-      std::fmodf(static_cast<float>(currentTimestamp) * 50.0f, 360.0f);
-  data.sphereData.position.x =
-      data.originalPosition.x +
-      glm::sin(glm::radians(degreeCycleCounter + data.cycleOffset)) *
-          data.movingScale.x;
-  data.sphereData.position.z =
-      data.originalPosition.z +
-      glm::cos(glm::radians(degreeCycleCounter + data.cycleOffset)) *
-          data.movingScale.z;
-};
+const GLuint& SphereGpuCullVaoProvider::culledInstanceVbo() const {
+  vao();
+  return _culledInstanceVbo;
+}
+
+const GLuint& SphereOrbitVaoProvider::vao() const {
+  static auto _ = std::invoke([this] {
+    glGenVertexArrays(1, &_vao);
+    RenderState::bindVertexArray(_vao);
+    meshProvider.attach();
+
+    glGenBuffers(1, &_instanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVbo);
+    glVertexAttribPointer(
+        2, 4, GL_FLOAT, GL_FALSE, sizeof(SphereOrbitInstance),
+        (GLvoid*)offsetof(SphereOrbitInstance, positionRadius));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE,
+                          sizeof(SphereOrbitInstance),
+                          (GLvoid*)offsetof(SphereOrbitInstance, color));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE,
+                          sizeof(SphereOrbitInstance),
+                          (GLvoid*)offsetof(SphereOrbitInstance, orbit));
+
+    glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(3);
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribDivisor(4, 1);
+    return 0;
+  });
+  return _vao;
+}
+
+const GLuint& SphereOrbitVaoProvider::instanceVbo() const {
+  vao();
+  return _instanceVbo;
+}
 
-const std::vector<glm::vec3>
-tessellateIcosahedron(const size_t& divisionCount) {
-  const std::array<glm::vec3, 5> baseVertices{
-      glm::vec3{std::cos(0), std::sin(0), 0},
-      {std::cos(2.f / 3.f * M_PI), std::sin(2.f / 3.f * M_PI), 0},
-      {std::cos(4.f / 3.f * M_PI), std::sin(4.f / 3.f * M_PI), 0},
-      {0, 0, 1},
-      {0, 0, -1}};
-
-  const std::array<std::array<glm::vec3, 3>, 6> triangles{{
-      {baseVertices.at(0), baseVertices.at(1), baseVertices.at(3)},
-      {baseVertices.at(0), baseVertices.at(2), baseVertices.at(3)},
-      {baseVertices.at(1), baseVertices.at(2), baseVertices.at(3)},
-      {baseVertices.at(0), baseVertices.at(1), baseVertices.at(4)},
-      {baseVertices.at(0), baseVertices.at(2), baseVertices.at(4)},
-      {baseVertices.at(1), baseVertices.at(2), baseVertices.at(4)},
-  }};
-
-  std::vector<glm::vec3> vertices{};
-
-  for (const auto& triangle : triangles) {
-    const auto divided{subdivideTriangle(triangle, divisionCount)};
-    vertices.insert(vertices.end(), divided.begin(), divided.end());
+// Compute shaders, shader storage buffers and multi-draw indirect are all
+// core in GL 4.3.
+bool SphereComponent::isGpuCullSupported() {
+  static const bool supported{GLAD_GL_VERSION_4_3 != 0};
+  return supported;
+}
+
+void SphereComponent::updateInstances(
+    const std::vector<SphereInstance>& _instances) {
+  instances = _instances;
+  bounds.resize(instances.size());
+  for (size_t i = 0; i < instances.size(); i++)
+    bounds[i] = instances[i].positionRadius;
+  isInstanceSsboStale = true;
+}
+
+void SphereComponent::setRenderMode(const SphereRenderMode& mode) noexcept {
+  renderMode = mode;
+}
+
+void SphereComponent::setCullMode(const SphereCullMode& mode) noexcept {
+  cullMode = mode;
+}
+
+void SphereComponent::setAnimationMode(
+    const SphereAnimationMode& mode) noexcept {
+  animationMode = mode;
+}
+
+// Uploads the orbits for good and bounds everything they can reach: the box
+// around every orbit, grown by the largest sphere radius.
+void SphereComponent::updateOrbits(
+    const std::vector<SphereOrbitInstance>& orbits) {
+  orbitCount = static_cast<GLsizei>(orbits.size());
+  glBindBuffer(GL_ARRAY_BUFFER, orbitVaoProvider.instanceVbo());
+  glBufferData(GL_ARRAY_BUFFER, orbits.size() * sizeof(SphereOrbitInstance),
+               orbits.data(), GL_STATIC_DRAW);
+
+  if (orbits.empty()) return;
+  glm::vec3 lower{std::numeric_limits<float>::max()};
+  glm::vec3 upper{std::numeric_limits<float>::lowest()};
+  auto radius{0.0f};
+  for (const auto& orbit : orbits) {
+    const glm::vec3 extent{orbit.orbit.x, 0.0f, orbit.orbit.y};
+    lower = glm::min(lower, glm::vec3{orbit.positionRadius} - extent);
+    upper = glm::max(upper, glm::vec3{orbit.positionRadius} + extent);
+    radius = std::max(radius, orbit.positionRadius.w);
   }
+  orbitBounds = {(lower + upper) / 2.0f,
+                 glm::length(upper - lower) / 2.0f + radius};
+}
+
+void SphereComponent::setAnimationTime(const float& time) noexcept {
+  animationTime = time;
+}
+
+// Each sphere is repeated once per view, so the instance attributes advance
+// every viewCount instances and the shader takes the view from the remainder.
+// The divisor is VAO state, so it is changed here rather than at submission.
+static void setInstanceDivisor(const GLuint& vao, GLuint& divisor,
+                               const GLsizei& viewCount) {
+  if (divisor == static_cast<GLuint>(viewCount)) return;
 
-  return vertices;
+  divisor = static_cast<GLuint>(viewCount);
+  RenderState::bindVertexArray(vao);
+  glVertexAttribDivisor(2, divisor);
+  glVertexAttribDivisor(3, divisor);
 }
 
-static const std::vector<glm::vec3>
-subdivideTriangle(const std::array<glm::vec3, 3>& triangle,
-                  const size_t& step) {
-  if (step == 0) return {triangle.begin(), triangle.end()};
+// Refilling a buffer orphans its previous storage, so the driver never has
+// to wait for the draws of an earlier view that still read from it.
+static void uploadInstances(const GLuint& vao, const GLuint& instanceVbo,
+                            const std::vector<SphereInstance>& instances,
+                            GLuint& divisor, const GLsizei& viewCount) {
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SphereInstance),
+               instances.data(), GL_STREAM_DRAW);
+  setInstanceDivisor(vao, divisor, viewCount);
+}
+
+void SphereComponent::enqueue(RenderQueue& queue) const {
+  if (animationMode == SphereAnimationMode::Shader)
+    return enqueueOrbits(queue);
+  if (renderMode == SphereRenderMode::Mesh &&
+      cullMode == SphereCullMode::Gpu && isGpuCullSupported())
+    return enqueueGpuCulled(queue);
+
+  const auto visible{queue.cull(bounds)};
+  if (renderMode == SphereRenderMode::Impostor)
+    return enqueueImpostors(queue, visible);
+
+  for (auto& level : levelInstances) level.clear();
+  for (size_t i = 0; i < instances.size(); i++)
+    if (visible[i])
+      levelInstances[static_cast<size_t>(queue.sphereLod(bounds[i]))]
+          .push_back(instances[i]);
 
-  const glm::vec3 v01{glm::normalize((triangle.at(0) + triangle.at(1)) / 2.f)};
-  const glm::vec3 v12{glm::normalize((triangle.at(1) + triangle.at(2)) / 2.f)};
-  const glm::vec3 v20{glm::normalize((triangle.at(2) + triangle.at(0)) / 2.f)};
+  for (size_t i = 0; i < levelInstances.size(); i++) {
+    const auto& levelInstance{levelInstances[i]};
+    if (levelInstance.empty()) continue;
 
-  std::vector<glm::vec3> vertices{};
-  const std::array<glm::vec3, 3> topTriangle{triangle.at(0), v01, v20};
-  const auto v1{subdivideTriangle(topTriangle, step - 1)};
-  vertices.insert(vertices.end(), v1.begin(), v1.end());
+    const auto level{static_cast<SphereLod>(i)};
+    const auto& vao{vaoProvider.vao(level)};
+    uploadInstances(vao, vaoProvider.instanceVbo(level), levelInstance,
+                    instanceDivisors[i], queue.viewCount());
+
+    const auto& mesh{meshProvider.lod(level)};
+    queue.push({.program{queue.programOf(shaderProgramProvider)},
+                .vao{vao},
+                .indexed{true},
+                .first{mesh.first},
+                .count{mesh.count},
+                .instanceCount{static_cast<GLsizei>(levelInstance.size()) *
+                               queue.viewCount()}});
+  }
+};
+
+void SphereComponent::enqueueImpostors(RenderQueue& queue,
+                                       std::span<const uint8_t> visible) const {
+  impostorInstances.clear();
+  for (size_t i = 0; i < instances.size(); i++)
+    if (visible[i]) impostorInstances.push_back(instances[i]);
+  if (impostorInstances.empty()) return;
+
+  uploadInstances(impostorVaoProvider.vao(), impostorVaoProvider.instanceVbo(),
+                  impostorInstances, impostorDivisor, queue.viewCount());
+
+  queue.push({.program{queue.programOf(impostorShaderProgramProvider)},
+              .vao{impostorVaoProvider.vao()},
+              .primitive{GL_TRIANGLE_STRIP},
+              .count{4},
+              .instanceCount{static_cast<GLsizei>(impostorInstances.size()) *
+                             queue.viewCount()}});
+}
+
+// The cull shader appends each visible sphere to the region of its level and
+// counts it in that level's command, which starts out with no instances. The
+// compacted instances and the commands are orphaned for every view, the same
+// as the instance buffers of the CPU path.
+void SphereComponent::enqueueGpuCulled(RenderQueue& queue) const {
+  if (instances.empty()) return;
+
+  if (instanceSsbo == 0) {
+    glGenBuffers(1, &instanceSsbo);
+    glGenBuffers(1, &commandBuffer);
+  }
+  if (isInstanceSsboStale) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceSsbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 instances.size() * sizeof(SphereInstance), instances.data(),
+                 GL_STREAM_DRAW);
+    isInstanceSsboStale = false;
+  }
+
+  const auto& vao{gpuCullVaoProvider.vao()};
+  const auto levelCapacity{static_cast<GLuint>(instances.size())};
+  glBindBuffer(GL_ARRAY_BUFFER, gpuCullVaoProvider.culledInstanceVbo());
+  glBufferData(GL_ARRAY_BUFFER,
+               SphereMesh::lodCount * levelCapacity * sizeof(SphereInstance),
+               nullptr, GL_STREAM_COPY);
+  setInstanceDivisor(vao, gpuCullDivisor, queue.viewCount());
+
+  std::array<DrawElementsIndirectCommand, SphereMesh::lodCount> commands{};
+  for (size_t i = 0; i < commands.size(); i++) {
+    const auto& mesh{meshProvider.lod(static_cast<SphereLod>(i))};
+    commands[i] = {.count{static_cast<GLuint>(mesh.count)},
+                   .instanceCount{0},
+                   .firstIndex{static_cast<GLuint>(mesh.first)},
+                   .baseVertex{0},
+                   .baseInstance{static_cast<GLuint>(i) * levelCapacity}};
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(commands), commands.data(),
+               GL_STREAM_DRAW);
+
+  auto block{queue.cullBlock()};
+  block.instanceCount = static_cast<GLuint>(instances.size());
+  block.levelCapacity = levelCapacity;
+  cullUniforms.upload(block);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceSsbo);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1,
+                   gpuCullVaoProvider.culledInstanceVbo());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+  RenderState::useProgram(cullShaderProgramProvider.program());
+  glDispatchCompute((levelCapacity + 63) / 64, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+  queue.push({.program{queue.programOf(shaderProgramProvider)},
+              .vao{vao},
+              .indexed{true},
+              .indirectBuffer{commandBuffer},
+              .drawCount{static_cast<GLsizei>(SphereMesh::lodCount)}});
+}
 
-  const std::array<glm::vec3, 3> leftTriangle{v01, triangle.at(1), v12};
-  const auto v2{subdivideTriangle(leftTriangle, step - 1)};
-  vertices.insert(vertices.end(), v2.begin(), v2.end());
+// The time is program state, so it is set here once per view rather than
+// carried by the packet.
+void SphereComponent::enqueueOrbits(RenderQueue& queue) const {
+  if (orbitCount == 0 || !queue.isVisible(orbitBounds)) return;
 
-  const std::array<glm::vec3, 3> rightTriangle{v20, v12, triangle.at(2)};
-  const auto v3{subdivideTriangle(rightTriangle, step - 1)};
-  vertices.insert(vertices.end(), v3.begin(), v3.end());
+  const auto& vao{orbitVaoProvider.vao()};
+  setInstanceDivisor(vao, orbitDivisor, queue.viewCount());
 
-  const std::array<glm::vec3, 3> midTriangle{v01, v12, v20};
-  const auto v4{subdivideTriangle(midTriangle, step - 1)};
-  vertices.insert(vertices.end(), v4.begin(), v4.end());
+  const auto& program{queue.programOf(orbitShaderProgramProvider)};
+  RenderState::useProgram(program);
+  setUniformToProgram(program, "time", animationTime);
 
-  return vertices;
+  const auto& mesh{meshProvider.lod(SphereLod::Level3)};
+  queue.push({.program{program},
+              .vao{vao},
+              .indexed{true},
+              .first{mesh.first},
+              .count{mesh.count},
+              .instanceCount{orbitCount * queue.viewCount()}});
 }
@@ -1,55 +1,173 @@
 #pragma once
-#define _USE_MATH_DEFINES
-
+#include <algorithm>
 #include <array>
-#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "render_queue.h"
 #include "shader.h"
-#include "user_control.h"
-
-const std::vector<glm::vec3> tessellateIcosahedron(const size_t& divisionCount);
+#include "sphere_mesh.h"
+#include "uniform_blocks.h"
 
+// One VAO per mesh level, each with its own instance buffer, so the spheres
+// drawn at a level are uploaded and drawn from the start of their buffer.
 class SphereVaoProvider {
 public:
-  const std::vector<glm::vec3> vertices{tessellateIcosahedron(3)};
+  const GLuint& vao(const SphereLod& level) const;
+  const GLuint& instanceVbo(const SphereLod& level) const;
+
+private:
+  static inline const SphereMeshProvider meshProvider{};
+  mutable std::array<GLuint, SphereMesh::lodCount> _vaos{};
+  mutable std::array<GLuint, SphereMesh::lodCount> _instanceVbos{};
+};
+
+// A single quad per sphere, drawn as a four-vertex strip, that the impostor
+// shader ray casts the sphere into.
+class SphereImpostorVaoProvider {
+public:
+  const GLuint& vao() const;
+  const GLuint& instanceVbo() const;
+
+private:
+  mutable GLuint _vao{};
+  mutable GLuint _instanceVbo{};
+};
+
+// Every mesh level and one buffer the cull shader compacts visible spheres
+// into, with a region of the same size per level. A single multi-draw then
+// covers all levels, each command's baseInstance pointing at its region.
+class SphereGpuCullVaoProvider {
+public:
   const GLuint& vao() const;
+  const GLuint& culledInstanceVbo() const;
 
 private:
+  static inline const SphereMeshProvider meshProvider{};
   mutable GLuint _vao{};
+  mutable GLuint _culledInstanceVbo{};
 };
 
+// One mesh level with a static buffer of orbit parameters, which the orbit
+// shader turns into sphere positions.
+class SphereOrbitVaoProvider {
+public:
+  const GLuint& vao() const;
+  const GLuint& instanceVbo() const;
+
+private:
+  static inline const SphereMeshProvider meshProvider{};
+  mutable GLuint _vao{};
+  mutable GLuint _instanceVbo{};
+};
+
+// Mesh draws an icosphere level per sphere; Impostor draws a quad and ray
+// casts the exact surface, normal and depth per fragment.
+enum class SphereRenderMode : uint8_t { Mesh, Impostor };
+
+// Cpu culls the spheres and picks their levels through RenderQueue; Gpu has
+// a compute shader do both and write the draw commands, so nothing is done
+// per sphere on the CPU. Gpu only applies to meshes and needs GL 4.3.
+enum class SphereCullMode : uint8_t { Cpu, Gpu };
+
+// Cpu moves the spheres along their orbits on the CPU every frame; Shader
+// uploads the orbits once and has the vertex shader place the spheres from
+// the animation time. Physics leaves the orbits for velocities and
+// collisions, on the CPU, and is drawn as Cpu is.
+enum class SphereAnimationMode : uint8_t { Cpu, Shader, Physics };
+
 struct SphereData {
   glm::vec3 position;
   glm::vec3 color;
+  float radius{0.05f};
 };
 
-struct AnimatedSphereDataV2 {
-  glm::vec3 originalPosition;
-  glm::vec3 movingScale;
-  float cycleOffset;
-  SphereData sphereData;
-  float speed;
+// Per-instance attributes as laid out in the instance buffer: the center in
+// xyz with the radius in w, then the color.
+struct SphereInstance {
+  glm::vec4 positionRadius;
+  glm::vec4 color;
 };
 
+// Per-instance attributes of the orbit shader: the orbit center in xyz with
+// the radius in w, the color, and the orbit's extents along x and z followed
+// by the sphere's phase in degrees and its speed in degrees per second.
+struct SphereOrbitInstance {
+  glm::vec4 positionRadius;
+  glm::vec4 color;
+  glm::vec4 orbit;
+};
+
+// Draws the spheres of the scene with one instanced call per mesh level and
+// view. updateInstances takes the whole set once per frame; each view then
+// culls it, sorts the survivors by the level their screen size calls for and
+// writes each level's instances to that level's buffer. In impostor mode the
+// survivors all go into one buffer and one draw instead.
+//
+// With GPU culling the whole set is uploaded once per frame instead, and
+// each view runs the cull shader over it. Those spheres are not counted in
+// the queue's culling and LOD stats, which would take a read back.
+//
+// When animated by the shader, the orbits stay in one static buffer and all
+// spheres are drawn from it with a single instanced call per view. The CPU
+// no longer knows where the spheres are, so they are culled only as a whole
+// against the bounds of every orbit, and all take the finest level the LOD
+// settings can pick.
 class SphereComponent {
 public:
-  SphereComponent();
-  SphereComponent(AnimatedSphereDataV2 data);
-  void render(const glm::mat4& view, const glm::mat4& proj,
-              const SphereData& data, const glm::vec3& viewPosition,
-              const glm::vec3& lightPosition) const;
-  void render(const glm::mat4& view, const glm::mat4& proj,
-              glm::vec3& viewPosition, glm::vec3& lightPosition,
-              UserControlData& userData) const;
-  void updatePosition(double& currentTimestamp);
+  static bool isGpuCullSupported();
+  void updateInstances(const std::vector<SphereInstance>& instances);
+  void setRenderMode(const SphereRenderMode& mode) noexcept;
+  void setCullMode(const SphereCullMode& mode) noexcept;
+  void setAnimationMode(const SphereAnimationMode& mode) noexcept;
+  void updateOrbits(const std::vector<SphereOrbitInstance>& orbits);
+  void setAnimationTime(const float& time) noexcept;
+  void enqueue(RenderQueue& queue) const;
 
 private:
-  static inline const LightingShaderProgramProvider shaderProgramProvider{};
+  static inline const InstancedLightingShaderProgramProvider
+      shaderProgramProvider{};
+  static inline const SphereImpostorShaderProgramProvider
+      impostorShaderProgramProvider{};
   static inline const SphereVaoProvider vaoProvider{};
-  struct AnimatedSphereDataV2 data {};
+  static inline const SphereImpostorVaoProvider impostorVaoProvider{};
+  static inline const SphereCullShaderProgramProvider
+      cullShaderProgramProvider{};
+  static inline const SphereGpuCullVaoProvider gpuCullVaoProvider{};
+  static inline const SphereOrbitShaderProgramProvider
+      orbitShaderProgramProvider{};
+  static inline const SphereOrbitVaoProvider orbitVaoProvider{};
+  static inline const SphereMeshProvider meshProvider{};
+  SphereRenderMode renderMode{SphereRenderMode::Mesh};
+  SphereCullMode cullMode{SphereCullMode::Cpu};
+  SphereAnimationMode animationMode{SphereAnimationMode::Cpu};
+  std::vector<SphereInstance> instances{};
+  std::vector<BoundingSphere> bounds{};
+  mutable std::array<std::vector<SphereInstance>, SphereMesh::lodCount>
+      levelInstances{};
+  mutable std::array<GLuint, SphereMesh::lodCount> instanceDivisors{
+      1, 1, 1, 1, 1, 1};
+  mutable std::vector<SphereInstance> impostorInstances{};
+  mutable GLuint impostorDivisor{1};
+  mutable GLuint instanceSsbo{};
+  mutable GLuint commandBuffer{};
+  mutable bool isInstanceSsboStale{true};
+  mutable GLuint gpuCullDivisor{1};
+  mutable CullUniformBuffer cullUniforms{};
+  GLsizei orbitCount{};
+  BoundingSphere orbitBounds{};
+  float animationTime{};
+  mutable GLuint orbitDivisor{1};
+
+  void enqueueImpostors(RenderQueue& queue,
+                        std::span<const uint8_t> visible) const;
+  void enqueueGpuCulled(RenderQueue& queue) const;
+  void enqueueOrbits(RenderQueue& queue) const;
 };
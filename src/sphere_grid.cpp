@@ -0,0 +1,272 @@
+#include "sphere_grid.h"
+
+// The grid is square, covering the larger side of the bounds.
+SphereGrid::SphereGrid(const glm::vec2& min, const glm::vec2& max)
+    : min{min}, size{std::max(max.x - min.x, max.y - min.y)}, cellSize{size} {}
+
+void SphereGrid::build(const SphereStore& spheres) {
+  const auto count{spheres.size()};
+  const auto chunkSize{
+      std::max(minChunkSize, (count + maxChunks - 1) / maxChunks)};
+  const auto chunkCount{(count + chunkSize - 1) / chunkSize};
+
+  chunkExtents.assign(chunkCount,
+                      {.maxRadius{0.0f},
+                       .minY{std::numeric_limits<float>::infinity()},
+                       .maxY{-std::numeric_limits<float>::infinity()}});
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    auto& extent{chunkExtents[first / chunkSize]};
+    for (size_t i = first; i < last; i++) {
+      extent.maxRadius = std::max(extent.maxRadius, spheres.radius[i]);
+      extent.minY = std::min(extent.minY, spheres.positionY[i]);
+      extent.maxY = std::max(extent.maxY, spheres.positionY[i]);
+    }
+  });
+  _maxRadius = 0.0f;
+  minY = std::numeric_limits<float>::infinity();
+  maxY = -std::numeric_limits<float>::infinity();
+  for (const auto& extent : chunkExtents) {
+    _maxRadius = std::max(_maxRadius, extent.maxRadius);
+    minY = std::min(minY, extent.minY);
+    maxY = std::max(maxY, extent.maxY);
+  }
+
+  const auto sideForCount{std::sqrt(static_cast<float>(count) / 8.0f)};
+  const auto sideForRadius{_maxRadius > 0.0f
+                               ? size / (2.0f * _maxRadius)
+                               : static_cast<float>(maxCellsPerSide)};
+  _cellsPerSide = std::clamp(
+      static_cast<uint32_t>(std::min(sideForCount, sideForRadius)), 1u,
+      maxCellsPerSide);
+  cellSize = size / static_cast<float>(_cellsPerSide);
+  const size_t cellCount{_cellsPerSide * _cellsPerSide};
+
+  sphereCells.resize(count);
+  chunkOffsets.assign(chunkCount * cellCount, 0);
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    const auto counts{chunkOffsets.data() + first / chunkSize * cellCount};
+    for (size_t i = first; i < last; i++) {
+      const auto cell{cellCoordinate(spheres.positionZ[i], min.y) *
+                          _cellsPerSide +
+                      cellCoordinate(spheres.positionX[i], min.x)};
+      sphereCells[i] = cell;
+      counts[cell]++;
+    }
+  });
+
+  // Every cell's spheres start after those of the cells before it, and
+  // within a cell, each chunk's after those of the chunks before it.
+  cellStart.resize(cellCount + 1);
+  cellStart[0] = 0;
+  parallelFor(cellCount, cellBlockSize,
+              [&](const size_t& first, const size_t& last) {
+                for (size_t cell = first; cell < last; cell++) {
+                  uint32_t total{};
+                  for (size_t chunk = 0; chunk < chunkCount; chunk++)
+                    total += chunkOffsets[chunk * cellCount + cell];
+                  cellStart[cell + 1] = total;
+                }
+              });
+  for (size_t cell = 0; cell < cellCount; cell++)
+    cellStart[cell + 1] += cellStart[cell];
+  parallelFor(cellCount, cellBlockSize,
+              [&](const size_t& first, const size_t& last) {
+                for (size_t cell = first; cell < last; cell++) {
+                  auto offset{cellStart[cell]};
+                  for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                    auto& chunkOffset{chunkOffsets[chunk * cellCount + cell]};
+                    const auto chunkTotal{chunkOffset};
+                    chunkOffset = offset;
+                    offset += chunkTotal;
+                  }
+                }
+              });
+
+  _indices.resize(count);
+  bounds.resize(count);
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    const auto offsets{chunkOffsets.data() + first / chunkSize * cellCount};
+    for (size_t i = first; i < last; i++) {
+      const auto slot{offsets[sphereCells[i]]++};
+      _indices[slot] = static_cast<uint32_t>(i);
+      bounds[slot] = BoundingSphere{spheres.positionX[i], spheres.positionY[i],
+                                    spheres.positionZ[i], spheres.radius[i]};
+    }
+  });
+}
+
+uint32_t SphereGrid::cellsPerSide() const noexcept { return _cellsPerSide; }
+
+std::span<const uint32_t> SphereGrid::indices() const noexcept {
+  return _indices;
+}
+
+float SphereGrid::maxRadius() const noexcept { return _maxRadius; }
+
+// Every sphere touching the sphere of the given center and radius.
+void SphereGrid::queryRadius(const glm::vec3& center, const float& radius,
+                             std::vector<uint32_t>& result) const {
+  result.clear();
+  const glm::vec2 center2{center.x, center.z};
+  const auto reach{radius + _maxRadius};
+  forEachCell(center2 - reach, center2 + reach,
+              [&](const uint32_t& first, const uint32_t& last) {
+                for (auto i = first; i < last; i++)
+                  if (glm::length(glm::vec3{bounds[i]} - center) <=
+                      radius + bounds[i].w)
+                    result.push_back(_indices[i]);
+              });
+}
+
+// Every sphere Frustum::intersects keeps. A cell is first tested as a box
+// grown by the largest radius and spanning the heights of all spheres: one
+// outside a plane is skipped and one inside all of them taken whole, so only
+// the spheres of cells crossing a plane go through the frustum's own test.
+void SphereGrid::queryFrustum(const Frustum& frustum,
+                              std::vector<uint32_t>& result) const {
+  result.clear();
+  const auto& planes{frustum.planes()};
+
+  for (uint32_t row = 0; row < _cellsPerSide; row++)
+    for (uint32_t column = 0; column < _cellsPerSide; column++) {
+      const auto cell{row * _cellsPerSide + column};
+      const auto first{cellStart[cell]};
+      const auto last{cellStart[cell + 1]};
+      if (first == last) continue;
+
+      const glm::vec3 low{min.x + column * cellSize - _maxRadius,
+                          minY - _maxRadius,
+                          min.y + row * cellSize - _maxRadius};
+      const auto high{low + glm::vec3{cellSize + 2.0f * _maxRadius,
+                                      maxY - minY + 2.0f * _maxRadius,
+                                      cellSize + 2.0f * _maxRadius}};
+
+      auto isOutside{false};
+      auto isInside{true};
+      for (const auto& plane : planes) {
+        const glm::vec3 normal{plane};
+        const glm::vec3 farthest{normal.x >= 0.0f ? high.x : low.x,
+                                 normal.y >= 0.0f ? high.y : low.y,
+                                 normal.z >= 0.0f ? high.z : low.z};
+        const glm::vec3 nearest{normal.x >= 0.0f ? low.x : high.x,
+                                normal.y >= 0.0f ? low.y : high.y,
+                                normal.z >= 0.0f ? low.z : high.z};
+        if (glm::dot(normal, farthest) + plane.w < 0.0f) {
+          isOutside = true;
+          break;
+        }
+        if (glm::dot(normal, nearest) + plane.w < 0.0f) isInside = false;
+      }
+      if (isOutside) continue;
+
+      if (isInside) {
+        result.insert(result.end(), _indices.begin() + first,
+                      _indices.begin() + last);
+        continue;
+      }
+      visibleMask.resize(last - first);
+      frustum.intersects({bounds.data() + first, last - first}, visibleMask);
+      for (auto i = first; i < last; i++)
+        if (visibleMask[i - first]) result.push_back(_indices[i]);
+    }
+}
+
+// Walks the cells the ray crosses in order (Amanatides and Woo), testing the
+// spheres of each cell and of those around it that a sphere could reach in
+// from. Any hit inside a cell has then been found by the time the walk
+// leaves it, so the walk stops at the first cell the nearest hit so far lies
+// within. A ray starting inside a sphere hits it where it leaves it.
+std::optional<SphereHit> SphereGrid::raycast(const glm::vec3& origin,
+                                             const glm::vec3& direction) const {
+  constexpr auto infinity{std::numeric_limits<float>::infinity()};
+  const auto unit{glm::normalize(direction)};
+
+  // Where the ray is over the grid and within the heights the spheres
+  // reach, from the slabs along each axis.
+  const std::array<glm::vec2, 3> slabs{
+      glm::vec2{min.x, min.x + size},
+      glm::vec2{minY - _maxRadius, maxY + _maxRadius},
+      glm::vec2{min.y, min.y + size}};
+  auto enter{0.0f};
+  auto exit{infinity};
+  for (int axis = 0; axis < 3; axis++) {
+    const auto& slab{slabs[axis]};
+    if (unit[axis] == 0.0f) {
+      if (origin[axis] < slab.x || origin[axis] > slab.y) return {};
+      continue;
+    }
+    const auto a{(slab.x - origin[axis]) / unit[axis]};
+    const auto b{(slab.y - origin[axis]) / unit[axis]};
+    enter = std::max(enter, std::min(a, b));
+    exit = std::min(exit, std::max(a, b));
+  }
+  if (enter > exit) return {};
+
+  const auto start{origin + unit * enter};
+  auto column{static_cast<int32_t>(cellCoordinate(start.x, min.x))};
+  auto row{static_cast<int32_t>(cellCoordinate(start.z, min.y))};
+  const auto stepX{unit.x > 0.0f ? 1 : -1};
+  const auto stepZ{unit.z > 0.0f ? 1 : -1};
+  const auto boundary{[&](const int32_t& cell, const int32_t& step,
+                          const float& low, const float& position,
+                          const float& component) {
+    if (component == 0.0f) return infinity;
+    const auto edge{low + static_cast<float>(cell + (step > 0)) * cellSize};
+    return enter + (edge - position) / component;
+  }};
+  auto nextX{boundary(column, stepX, min.x, start.x, unit.x)};
+  auto nextZ{boundary(row, stepZ, min.y, start.z, unit.z)};
+  const auto deltaX{unit.x == 0.0f ? infinity : cellSize / std::abs(unit.x)};
+  const auto deltaZ{unit.z == 0.0f ? infinity : cellSize / std::abs(unit.z)};
+
+  std::optional<SphereHit> hit{};
+  const auto ring{static_cast<float>(ringSize()) * cellSize};
+  while (true) {
+    const glm::vec2 center{min.x + (column + 0.5f) * cellSize,
+                           min.y + (row + 0.5f) * cellSize};
+    forEachCell(center - ring, center + ring,
+                [&](const uint32_t& first, const uint32_t& last) {
+                  for (auto i = first; i < last; i++) {
+                    const auto offset{glm::vec3{bounds[i]} - origin};
+                    const auto along{glm::dot(offset, unit)};
+                    const auto discriminant{along * along -
+                                            glm::dot(offset, offset) +
+                                            bounds[i].w * bounds[i].w};
+                    if (discriminant < 0.0f) continue;
+                    auto distance{along - std::sqrt(discriminant)};
+                    if (distance < 0.0f)
+                      distance = along + std::sqrt(discriminant);
+                    if (distance >= 0.0f &&
+                        (!hit || distance < hit->distance))
+                      hit = SphereHit{.index{_indices[i]},
+                                      .distance{distance}};
+                  }
+                });
+
+    const auto cellExit{std::min({nextX, nextZ, exit})};
+    if ((hit && hit->distance <= cellExit) || cellExit >= exit) return hit;
+    if (nextX < nextZ) {
+      column += stepX;
+      nextX += deltaX;
+    } else {
+      row += stepZ;
+      nextZ += deltaZ;
+    }
+    const auto cells{static_cast<int32_t>(_cellsPerSide)};
+    if (column < 0 || row < 0 || column >= cells || row >= cells) return hit;
+  }
+}
+
+uint32_t SphereGrid::cellCoordinate(const float& value,
+                                    const float& origin) const {
+  return static_cast<uint32_t>(
+      std::clamp((value - origin) / cellSize, 0.0f,
+                 static_cast<float>(_cellsPerSide - 1)));
+}
+
+// How many cells away a sphere can reach into, which is one unless the
+// bounds are so small that cells had to be kept under a sphere across.
+uint32_t SphereGrid::ringSize() const {
+  return std::max(
+      1u, static_cast<uint32_t>(std::ceil(_maxRadius / cellSize)));
+}
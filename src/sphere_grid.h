@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustum.h"
+#include "parallel_for.h"
+#include "sphere_store.h"
+
+// The sphere a ray hits first and how far along the ray the hit is.
+struct SphereHit {
+  uint32_t index;
+  float distance;
+};
+
+// A uniform grid over the xz plane of the room, with every sphere in the
+// cell its center falls in; centers outside the bounds go to the border
+// cells. It is rebuilt from the positions of a SphereStore rather than
+// updated, and holds the bounding sphere of each sphere in cell order so a
+// query reads the spheres of a cell from consecutive memory.
+// Queries return indices into the store, and are exact for spheres inside
+// the bounds, which is where the orbits keep them. The frustum query keeps
+// scratch space in the grid, so queries on one grid run one at a time.
+//
+// Cells are at least a sphere across, so a sphere reaches no further than
+// the neighbouring cells, and hold about eight spheres when the spheres are
+// small enough for that.
+//
+// The build counts the spheres of every chunk per cell in parallel, turns
+// the counts into offsets one range of cells at a time and scatters the
+// chunks in parallel again. A cell lists its spheres by index whatever the
+// number of threads.
+class SphereGrid {
+public:
+  static constexpr uint32_t maxCellsPerSide{512};
+
+  SphereGrid(const glm::vec2& min, const glm::vec2& max);
+  void build(const SphereStore& spheres);
+  uint32_t cellsPerSide() const noexcept;
+  std::span<const uint32_t> indices() const noexcept;
+  float maxRadius() const noexcept;
+  template <typename Body>
+  void forEachCell(const glm::vec2& low, const glm::vec2& high,
+                   const Body& body) const;
+  void queryRadius(const glm::vec3& center, const float& radius,
+                   std::vector<uint32_t>& result) const;
+  void queryFrustum(const Frustum& frustum,
+                    std::vector<uint32_t>& result) const;
+  std::optional<SphereHit> raycast(const glm::vec3& origin,
+                                   const glm::vec3& direction) const;
+
+private:
+  struct ChunkExtent {
+    float maxRadius;
+    float minY;
+    float maxY;
+  };
+
+  static constexpr size_t minChunkSize{65536};
+  static constexpr size_t maxChunks{16};
+  static constexpr size_t cellBlockSize{4096};
+
+  glm::vec2 min{};
+  float size{};
+  uint32_t _cellsPerSide{1};
+  float cellSize{};
+  float _maxRadius{};
+  float minY{};
+  float maxY{};
+  std::vector<uint32_t> cellStart{0, 0};
+  std::vector<uint32_t> _indices{};
+  std::vector<BoundingSphere> bounds{};
+  std::vector<ChunkExtent> chunkExtents{};
+  std::vector<uint32_t> sphereCells{};
+  std::vector<uint32_t> chunkOffsets{};
+  mutable std::vector<uint8_t> visibleMask{};
+
+  uint32_t cellCoordinate(const float& value, const float& origin) const;
+  uint32_t ringSize() const;
+};
+
+// Calls body(first, last) with the slots, in the order of indices(), of the
+// spheres in the cells the xz rectangle between low and high overlaps. The
+// cells of a row have consecutive slots, so that is one range per row.
+template <typename Body>
+void SphereGrid::forEachCell(const glm::vec2& low, const glm::vec2& high,
+                             const Body& body) const {
+  const auto firstColumn{cellCoordinate(low.x, min.x)};
+  const auto lastColumn{cellCoordinate(high.x, min.x)};
+  const auto firstRow{cellCoordinate(low.y, min.y)};
+  const auto lastRow{cellCoordinate(high.y, min.y)};
+  for (auto row = firstRow; row <= lastRow; row++) {
+    const auto first{cellStart[row * _cellsPerSide + firstColumn]};
+    const auto last{cellStart[row * _cellsPerSide + lastColumn + 1]};
+    if (first != last) body(first, last);
+  }
+}
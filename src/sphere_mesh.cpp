@@ -0,0 +1,221 @@
+#include "sphere_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+
+static std::vector<GLuint> subdivide(std::vector<glm::vec3>& positions,
+                                     const std::vector<GLuint>& triangles);
+static std::vector<GLuint>
+optimizeVertexCache(const std::vector<GLuint>& indices,
+                    const size_t& vertexCount);
+
+SphereMesh buildSphereMesh() {
+  // The 12 vertices of the icosahedron lie on three orthogonal golden
+  // rectangles.
+  const auto t{(1.0f + std::sqrt(5.0f)) / 2.0f};
+  std::vector<glm::vec3> positions{
+      {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+      {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+      {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+  for (auto& position : positions) position = glm::normalize(position);
+
+  std::vector<GLuint> triangles{
+      0, 11, 5,  0, 5,  1, 0,  1, 7, 0,  7, 10, 0, 10, 11,
+      1, 5,  9,  5, 11, 4, 11, 10, 2, 10, 7, 6,  7, 1,  8,
+      3, 9,  4,  3, 4,  2, 3,  2, 6, 3,  6, 8,  3, 8,  9,
+      4, 9,  5,  2, 4,  11, 6, 2, 10, 8, 6, 7,  9, 8,  1};
+
+  SphereMesh mesh{};
+  for (size_t level = 0; level < SphereMesh::lodCount; level++) {
+    if (level > 0) triangles = subdivide(positions, triangles);
+
+    // Only the vertices this level uses are kept, renumbered in the order the
+    // optimized triangles first touch them.
+    const auto ordered{optimizeVertexCache(triangles, positions.size())};
+    std::vector<GLuint> remap(positions.size(), ~GLuint{});
+    const auto base{static_cast<GLuint>(mesh.vertices.size())};
+
+    mesh.lods[level] = {.first{static_cast<GLint>(mesh.indices.size())},
+                        .count{static_cast<GLsizei>(ordered.size())}};
+    for (const auto& index : ordered) {
+      if (remap[index] == ~GLuint{}) {
+        remap[index] = static_cast<GLuint>(mesh.vertices.size()) - base;
+        mesh.vertices.push_back(
+            {.position{positions[index]}, .normal{positions[index]}});
+      }
+      mesh.indices.push_back(base + remap[index]);
+    }
+  }
+
+  return mesh;
+}
+
+// Splits every triangle into four. Midpoints are shared through a map keyed
+// on the edge, so neighbouring triangles reuse the same vertex.
+static std::vector<GLuint> subdivide(std::vector<glm::vec3>& positions,
+                                     const std::vector<GLuint>& triangles) {
+  std::unordered_map<uint64_t, GLuint> midpoints{};
+  midpoints.reserve(triangles.size());
+
+  const auto midpoint{[&](const GLuint& a, const GLuint& b) {
+    const auto key{static_cast<uint64_t>(std::min(a, b)) << 32 |
+                   std::max(a, b)};
+    const auto [it, isNew]{
+        midpoints.try_emplace(key, static_cast<GLuint>(positions.size()))};
+    if (isNew)
+      positions.push_back(glm::normalize(positions[a] + positions[b]));
+    return it->second;
+  }};
+
+  std::vector<GLuint> subdivided{};
+  subdivided.reserve(triangles.size() * 4);
+  for (size_t i = 0; i < triangles.size(); i += 3) {
+    const auto v0{triangles[i]}, v1{triangles[i + 1]}, v2{triangles[i + 2]};
+    const auto v01{midpoint(v0, v1)};
+    const auto v12{midpoint(v1, v2)};
+    const auto v20{midpoint(v2, v0)};
+    subdivided.insert(subdivided.end(), {v0, v01, v20, v01, v1, v12, v20, v12,
+                                         v2, v01, v12, v20});
+  }
+  return subdivided;
+}
+
+// Tom Forsyth's linear-speed vertex cache optimization: triangles are emitted
+// greedily by the summed score of their vertices, which favours vertices
+// still in a simulated LRU cache and vertices with few triangles left.
+static std::vector<GLuint>
+optimizeVertexCache(const std::vector<GLuint>& indices,
+                    const size_t& vertexCount) {
+  constexpr size_t cacheSize{32};
+  const auto triangleCount{indices.size() / 3};
+
+  std::vector<uint32_t> remaining(vertexCount, 0);
+  for (const auto& index : indices) remaining[index]++;
+
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; v++)
+    adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+  std::vector<uint32_t> adjacency(indices.size());
+  {
+    auto cursor{adjacencyOffsets};
+    for (size_t i = 0; i < indices.size(); i++)
+      adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<int32_t> cachePosition(vertexCount, -1);
+  const auto vertexScore{[&](const size_t& v) {
+    if (remaining[v] == 0) return -1.0f;
+
+    auto score{0.0f};
+    if (const auto position{cachePosition[v]}; position >= 0) {
+      if (position < 3)
+        score = 0.75f;
+      else
+        score = std::pow(1.0f - static_cast<float>(position - 3) /
+                                    (cacheSize - 3),
+                         1.5f);
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(remaining[v]));
+  }};
+
+  std::vector<float> scores(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++) scores[v] = vertexScore(v);
+
+  std::vector<bool> isEmitted(triangleCount, false);
+  const auto triangleScore{[&](const size_t& t) {
+    return scores[indices[t * 3]] + scores[indices[t * 3 + 1]] +
+           scores[indices[t * 3 + 2]];
+  }};
+
+  std::vector<GLuint> ordered{};
+  ordered.reserve(indices.size());
+  std::vector<GLuint> cache{};
+  size_t nextUnemitted{0};
+
+  for (size_t emitted = 0; emitted < triangleCount; emitted++) {
+    // The best candidate is taken from the triangles around cached vertices;
+    // with an empty neighbourhood the next unemitted triangle starts over.
+    auto best{triangleCount};
+    auto bestScore{-1.0f};
+    for (const auto& v : cache)
+      for (auto i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+        if (const auto t{adjacency[i]}; !isEmitted[t])
+          if (const auto score{triangleScore(t)}; score > bestScore) {
+            best = t;
+            bestScore = score;
+          }
+    if (best == triangleCount) {
+      while (isEmitted[nextUnemitted]) nextUnemitted++;
+      best = nextUnemitted;
+    }
+
+    isEmitted[best] = true;
+    for (size_t k = 0; k < 3; k++) {
+      const auto v{indices[best * 3 + k]};
+      ordered.push_back(v);
+      remaining[v]--;
+
+      cache.erase(std::remove(cache.begin(), cache.end(), v), cache.end());
+      cache.insert(cache.begin(), v);
+    }
+
+    // Vertices pushed out of the cache lose their position score; the rest
+    // are rescored for their new position.
+    for (size_t i = cacheSize; i < cache.size(); i++) {
+      cachePosition[cache[i]] = -1;
+      scores[cache[i]] = vertexScore(cache[i]);
+    }
+    if (cache.size() > cacheSize) cache.resize(cacheSize);
+    for (size_t i = 0; i < cache.size(); i++) {
+      cachePosition[cache[i]] = static_cast<int32_t>(i);
+      scores[cache[i]] = vertexScore(cache[i]);
+    }
+  }
+
+  return ordered;
+}
+
+// Binds the shared buffers to the currently bound VAO: the position on
+// attribute 0 and the normal on attribute 1.
+void SphereMeshProvider::attach() const {
+  upload();
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+  glVertexAttribPointer(0, sizeof(SphereVertex::position) / sizeof(GLfloat),
+                        GL_FLOAT, GL_FALSE, sizeof(SphereVertex),
+                        (GLvoid*)offsetof(SphereVertex, position));
+  glVertexAttribPointer(1, sizeof(SphereVertex::normal) / sizeof(GLfloat),
+                        GL_FLOAT, GL_FALSE, sizeof(SphereVertex),
+                        (GLvoid*)offsetof(SphereVertex, normal));
+
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+}
+
+const SphereLodRange& SphereMeshProvider::lod(const SphereLod& level) const {
+  upload();
+  return lods[static_cast<size_t>(level)];
+}
+
+// The element buffer is only bound to a VAO by attach, so uploading it here
+// must not disturb whichever VAO happens to be bound.
+void SphereMeshProvider::upload() const {
+  static auto _ = std::invoke([] {
+    const auto mesh{buildSphereMesh()};
+    lods = mesh.lods;
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(SphereVertex),
+                 mesh.vertices.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, mesh.indices.size() * sizeof(GLuint),
+                 mesh.indices.data(), GL_STATIC_DRAW);
+    return 0;
+  });
+}
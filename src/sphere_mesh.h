@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Subdivision levels of the unit icosphere. Level n has 20 * 4^n triangles.
+enum class SphereLod : uint8_t {
+  Level0,
+  Level1,
+  Level2,
+  Level3,
+  Level4,
+  Level5
+};
+
+struct SphereVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+};
+
+// The part of the shared index buffer holding one level. Indices are
+// absolute, so a level is drawn with glDrawElements over this range alone.
+struct SphereLodRange {
+  GLint first;
+  GLsizei count;
+};
+
+// Every level of the icosphere packed into one vertex and one index array.
+// Each level's triangles are ordered for the post-transform vertex cache and
+// its vertices are ordered by first use.
+struct SphereMesh {
+  static constexpr size_t lodCount{6};
+  std::vector<SphereVertex> vertices;
+  std::vector<GLuint> indices;
+  std::array<SphereLodRange, lodCount> lods;
+};
+
+SphereMesh buildSphereMesh();
+
+// Owns the GPU copy of the icosphere chain. The buffers are created once and
+// shared by every instance, so all sphere-like components draw from the same
+// geometry and only differ in the VAO they attach it to.
+class SphereMeshProvider {
+public:
+  void attach() const;
+  const SphereLodRange& lod(const SphereLod& level) const;
+
+private:
+  static inline GLuint vbo{};
+  static inline GLuint ebo{};
+  static inline std::array<SphereLodRange, SphereMesh::lodCount> lods{};
+
+  void upload() const;
+};
@@ -0,0 +1,262 @@
+#include "sphere_physics.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#define SPHERE_PHYSICS_AVX2
+#endif
+
+// A sphere as the contact test sees it, and what the spheres it overlaps
+// add to its velocity and position.
+struct Contact {
+  float x;
+  float z;
+  float radius;
+  float mass;
+  float velocityX;
+  float velocityZ;
+};
+
+struct ContactSums {
+  float velocityX;
+  float velocityZ;
+  float x;
+  float z;
+  float count;
+};
+
+// Adds what the spheres in grid slots [first, last) do to the given one.
+// Each contact weighs by the share of the pair's mass the other sphere
+// makes up; the sphere itself, at zero distance, and spheres it does not
+// overlap add nothing.
+static void addContacts(const Contact& sphere, const float* x, const float* z,
+                        const float* radius, const float* mass,
+                        const float* velocityX, const float* velocityZ,
+                        const uint32_t& first, const uint32_t& last,
+                        ContactSums& sums) {
+  auto j{first};
+
+#ifdef SPHERE_PHYSICS_AVX2
+  const auto sphereX{_mm256_set1_ps(sphere.x)};
+  const auto sphereZ{_mm256_set1_ps(sphere.z)};
+  const auto sphereRadius{_mm256_set1_ps(sphere.radius)};
+  const auto sphereMass{_mm256_set1_ps(sphere.mass)};
+  const auto sphereVelocityX{_mm256_set1_ps(sphere.velocityX)};
+  const auto sphereVelocityZ{_mm256_set1_ps(sphere.velocityZ)};
+  const auto zero{_mm256_setzero_ps()};
+  auto sumVelocityX{zero};
+  auto sumVelocityZ{zero};
+  auto sumX{zero};
+  auto sumZ{zero};
+  auto sumCount{zero};
+
+  for (; j + 8 <= last; j += 8) {
+    const auto dx{_mm256_sub_ps(sphereX, _mm256_loadu_ps(x + j))};
+    const auto dz{_mm256_sub_ps(sphereZ, _mm256_loadu_ps(z + j))};
+    const auto distanceSquared{
+        _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz))};
+    const auto reach{_mm256_add_ps(sphereRadius, _mm256_loadu_ps(radius + j))};
+    const auto isContact{_mm256_and_ps(
+        _mm256_cmp_ps(distanceSquared, _mm256_mul_ps(reach, reach),
+                      _CMP_LT_OQ),
+        _mm256_cmp_ps(distanceSquared, zero, _CMP_GT_OQ))};
+    if (_mm256_movemask_ps(isContact) == 0) continue;
+
+    // Lanes without a contact may divide by zero; their sums are masked out.
+    const auto distance{_mm256_sqrt_ps(distanceSquared)};
+    const auto normalX{_mm256_div_ps(dx, distance)};
+    const auto normalZ{_mm256_div_ps(dz, distance)};
+    const auto otherMass{_mm256_loadu_ps(mass + j)};
+    const auto share{
+        _mm256_div_ps(otherMass, _mm256_add_ps(sphereMass, otherMass))};
+    const auto approach{_mm256_add_ps(
+        _mm256_mul_ps(_mm256_sub_ps(sphereVelocityX,
+                                    _mm256_loadu_ps(velocityX + j)),
+                      normalX),
+        _mm256_mul_ps(_mm256_sub_ps(sphereVelocityZ,
+                                    _mm256_loadu_ps(velocityZ + j)),
+                      normalZ))};
+    const auto impulse{
+        _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), share),
+                      _mm256_min_ps(approach, zero))};
+    const auto push{_mm256_mul_ps(_mm256_sub_ps(reach, distance), share)};
+
+    sumVelocityX = _mm256_add_ps(sumVelocityX,
+                                 _mm256_and_ps(_mm256_mul_ps(impulse, normalX),
+                                               isContact));
+    sumVelocityZ = _mm256_add_ps(sumVelocityZ,
+                                 _mm256_and_ps(_mm256_mul_ps(impulse, normalZ),
+                                               isContact));
+    sumX = _mm256_add_ps(
+        sumX, _mm256_and_ps(_mm256_mul_ps(push, normalX), isContact));
+    sumZ = _mm256_add_ps(
+        sumZ, _mm256_and_ps(_mm256_mul_ps(push, normalZ), isContact));
+    sumCount = _mm256_add_ps(sumCount,
+                             _mm256_and_ps(_mm256_set1_ps(1.0f), isContact));
+  }
+
+  const auto horizontalSum{[](const __m256& lanes) {
+    alignas(32) float values[8];
+    _mm256_store_ps(values, lanes);
+    auto sum{0.0f};
+    for (const auto& value : values) sum += value;
+    return sum;
+  }};
+  sums.velocityX += horizontalSum(sumVelocityX);
+  sums.velocityZ += horizontalSum(sumVelocityZ);
+  sums.x += horizontalSum(sumX);
+  sums.z += horizontalSum(sumZ);
+  sums.count += horizontalSum(sumCount);
+#endif
+
+  for (; j < last; j++) {
+    const auto dx{sphere.x - x[j]};
+    const auto dz{sphere.z - z[j]};
+    const auto distanceSquared{dx * dx + dz * dz};
+    const auto reach{sphere.radius + radius[j]};
+    if (distanceSquared >= reach * reach || distanceSquared <= 0.0f) continue;
+
+    const auto distance{std::sqrt(distanceSquared)};
+    const auto normalX{dx / distance};
+    const auto normalZ{dz / distance};
+    const auto share{mass[j] / (sphere.mass + mass[j])};
+    const auto approach{(sphere.velocityX - velocityX[j]) * normalX +
+                        (sphere.velocityZ - velocityZ[j]) * normalZ};
+    const auto impulse{-2.0f * share * std::min(approach, 0.0f)};
+    const auto push{(reach - distance) * share};
+    sums.velocityX += impulse * normalX;
+    sums.velocityZ += impulse * normalZ;
+    sums.x += push * normalX;
+    sums.z += push * normalZ;
+    sums.count += 1.0f;
+  }
+}
+
+SpherePhysics::SpherePhysics(const glm::vec2& min, const glm::vec2& max)
+    : min{min}, max{max}, grid{min, max} {}
+
+// Sets every sphere off along its orbit, at the velocity the orbit had at
+// the given animation time, from where the orbit put it then.
+void SpherePhysics::start(SphereStore& spheres, const float& animationTime) {
+  constexpr auto radiansPerDegree{0.017453292519943295f};
+  animateSpheres(spheres, animationTime);
+  pendingSeconds = 0.0;
+
+  const auto count{spheres.size()};
+  velocityX.resize(count);
+  velocityZ.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    const auto angle{(animationTime * spheres.speed[i] +
+                      spheres.cycleOffset[i]) *
+                     radiansPerDegree};
+    const auto angularSpeed{spheres.speed[i] * radiansPerDegree};
+    velocityX[i] = spheres.scaleX[i] * std::cos(angle) * angularSpeed;
+    velocityZ[i] = -spheres.scaleZ[i] * std::sin(angle) * angularSpeed;
+  }
+}
+
+// Runs as many whole steps as the time since the last update covers, up to
+// maxStepsPerUpdate; time beyond that is dropped rather than caught up on.
+// Timestamps a step apart can differ from the step by a rounding error, so
+// what is within a thousandth of a step counts as a whole one.
+void SpherePhysics::advance(SphereStore& spheres, const double& seconds) {
+  pendingSeconds += seconds;
+  const auto steps{std::min(
+      static_cast<int>(pendingSeconds / timestep + 1e-3), maxStepsPerUpdate)};
+  pendingSeconds =
+      std::clamp(pendingSeconds - steps * timestep, 0.0, timestep);
+  for (int i = 0; i < steps; i++) step(spheres);
+}
+
+void SpherePhysics::step(SphereStore& spheres) {
+  const auto count{spheres.size()};
+  grid.build(spheres);
+  const auto indices{grid.indices()};
+
+  sortedX.resize(count);
+  sortedZ.resize(count);
+  sortedRadius.resize(count);
+  sortedMass.resize(count);
+  sortedVelocityX.resize(count);
+  sortedVelocityZ.resize(count);
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    for (size_t slot = first; slot < last; slot++) {
+      const auto i{indices[slot]};
+      sortedX[slot] = spheres.positionX[i];
+      sortedZ[slot] = spheres.positionZ[i];
+      sortedRadius[slot] = spheres.radius[i];
+      sortedMass[slot] =
+          spheres.radius[i] * spheres.radius[i] * spheres.radius[i];
+      sortedVelocityX[slot] = velocityX[i];
+      sortedVelocityZ[slot] = velocityZ[i];
+    }
+  });
+
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    collide(spheres, first, last);
+  });
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    move(spheres, first, last);
+  });
+}
+
+// Resolves the contacts of the spheres in grid slots [first, last). Each
+// writes only its own velocity and position, so the ranges run in parallel.
+void SpherePhysics::collide(SphereStore& spheres, const size_t& first,
+                            const size_t& last) {
+  const auto indices{grid.indices()};
+  const auto maxRadius{grid.maxRadius()};
+
+  for (auto slot = first; slot < last; slot++) {
+    const Contact sphere{.x{sortedX[slot]},
+                         .z{sortedZ[slot]},
+                         .radius{sortedRadius[slot]},
+                         .mass{sortedMass[slot]},
+                         .velocityX{sortedVelocityX[slot]},
+                         .velocityZ{sortedVelocityZ[slot]}};
+    const auto reach{sphere.radius + maxRadius};
+    ContactSums sums{};
+    grid.forEachCell(
+        {sphere.x - reach, sphere.z - reach},
+        {sphere.x + reach, sphere.z + reach},
+        [&](const uint32_t& rangeFirst, const uint32_t& rangeLast) {
+          addContacts(sphere, sortedX.data(), sortedZ.data(),
+                      sortedRadius.data(), sortedMass.data(),
+                      sortedVelocityX.data(), sortedVelocityZ.data(),
+                      rangeFirst, rangeLast, sums);
+        });
+
+    // Adding up several contacts computed from the same velocities would
+    // let a crowd gain energy, so a sphere takes their average instead.
+    const auto i{indices[slot]};
+    const auto weight{sums.count > 0.0f ? 1.0f / sums.count : 0.0f};
+    velocityX[i] = sphere.velocityX + sums.velocityX * weight;
+    velocityZ[i] = sphere.velocityZ + sums.velocityZ * weight;
+    spheres.positionX[i] = sphere.x + sums.x * weight;
+    spheres.positionZ[i] = sphere.z + sums.z * weight;
+  }
+}
+
+// Moves the spheres in [first, last) by one step and mirrors those that end
+// up past a wall back inside, heading away from it.
+void SpherePhysics::move(SphereStore& spheres, const size_t& first,
+                         const size_t& last) {
+  constexpr auto seconds{static_cast<float>(timestep)};
+  const auto bounce{[](float& position, float& velocity, const float& low,
+                       const float& high) {
+    if (position < low) {
+      position = std::min(2.0f * low - position, high);
+      velocity = std::abs(velocity);
+    } else if (position > high) {
+      position = std::max(2.0f * high - position, low);
+      velocity = -std::abs(velocity);
+    }
+  }};
+
+  for (auto i = first; i < last; i++) {
+    const auto radius{spheres.radius[i]};
+    spheres.positionX[i] += velocityX[i] * seconds;
+    spheres.positionZ[i] += velocityZ[i] * seconds;
+    bounce(spheres.positionX[i], velocityX[i], min.x + radius, max.x - radius);
+    bounce(spheres.positionZ[i], velocityZ[i], min.y + radius, max.y - radius);
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "parallel_for.h"
+#include "sphere_grid.h"
+#include "sphere_store.h"
+
+// Rolls the spheres across the floor with constant velocities, bouncing
+// them elastically off each other and off the walls, with masses growing
+// with the cube of the radius. The spheres stay at their height, so all of
+// it happens in the xz plane.
+//
+// Time advances in fixed steps, so the same spheres always end up in the
+// same place after the same number of steps, however the steps are spread
+// over updates and whatever the number of threads. Each step:
+// - rebuilds a SphereGrid as the broadphase, then copies every sphere's
+//   position, radius and velocity into the grid's order, so the spheres a
+//   sphere can touch are in a few consecutive ranges;
+// - has every sphere average the impulses and push-outs of the spheres it
+//   overlaps, from the copies, and apply them to itself only. Contacts are
+//   thus resolved all at once rather than one after another, and a sphere
+//   deep in a crowd may need a few steps to get out;
+// - moves the spheres and reflects those past a wall.
+//
+// The walls are the sides of the xz rectangle between min and max.
+class SpherePhysics {
+public:
+  static constexpr double timestep{1.0 / 60.0};
+  static constexpr int maxStepsPerUpdate{4};
+
+  SpherePhysics(const glm::vec2& min, const glm::vec2& max);
+  void start(SphereStore& spheres, const float& animationTime);
+  void advance(SphereStore& spheres, const double& seconds);
+  void step(SphereStore& spheres);
+
+private:
+  static constexpr size_t chunkSize{4096};
+
+  glm::vec2 min{};
+  glm::vec2 max{};
+  SphereGrid grid;
+  double pendingSeconds{};
+  std::vector<float> velocityX{};
+  std::vector<float> velocityZ{};
+  std::vector<float> sortedX{};
+  std::vector<float> sortedZ{};
+  std::vector<float> sortedRadius{};
+  std::vector<float> sortedMass{};
+  std::vector<float> sortedVelocityX{};
+  std::vector<float> sortedVelocityZ{};
+
+  void collide(SphereStore& spheres, const size_t& first,
+               const size_t& last);
+  void move(SphereStore& spheres, const size_t& first,
+            const size_t& last);
+};
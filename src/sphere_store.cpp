@@ -0,0 +1,184 @@
+#include "sphere_store.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#define SPHERE_STORE_AVX2
+#endif
+
+size_t SphereStore::size() const noexcept { return speed.size(); }
+
+void SphereStore::add(const AnimatedSphereData& sphere) {
+  originX.push_back(sphere.originalPosition.x);
+  originY.push_back(sphere.originalPosition.y);
+  originZ.push_back(sphere.originalPosition.z);
+  scaleX.push_back(sphere.movingScale.x);
+  scaleZ.push_back(sphere.movingScale.z);
+  cycleOffset.push_back(sphere.cycleOffset);
+  speed.push_back(sphere.speed);
+  radius.push_back(sphere.sphereData.radius);
+  colorR.push_back(sphere.sphereData.color.x);
+  colorG.push_back(sphere.sphereData.color.y);
+  colorB.push_back(sphere.sphereData.color.z);
+  positionX.push_back(sphere.sphereData.position.x);
+  positionY.push_back(sphere.sphereData.position.y);
+  positionZ.push_back(sphere.sphereData.position.z);
+}
+
+void SphereStore::resize(const size_t& count) {
+  for (auto field : {&originX, &originY, &originZ, &scaleX, &scaleZ,
+                     &cycleOffset, &speed, &radius, &colorR, &colorG, &colorB,
+                     &positionX, &positionY, &positionZ})
+    field->resize(count);
+}
+
+// Replaces the spheres with count random ones resting on the floor, each on
+// an orbit that stays inside the room. Sphere i draws from stream i of the
+// seed, so the spheres come out the same in any chunks on any number of
+// threads.
+void generateSpheres(SphereStore& spheres, const uint64_t& seed,
+                     const size_t& count) {
+  constexpr size_t chunkSize{16384};
+  spheres.resize(count);
+  parallelFor(count, chunkSize, [&](const size_t& first, const size_t& last) {
+    for (size_t i = first; i < last; i++) {
+      CounterRng rng{seed, i};
+      const auto x{rng.uniform(-0.75f, 0.75f)};
+      const auto z{rng.uniform(-0.75f, 0.75f)};
+      spheres.originX[i] = spheres.positionX[i] = x;
+      spheres.originY[i] = spheres.positionY[i] = 0.05f;
+      spheres.originZ[i] = spheres.positionZ[i] = z;
+      spheres.scaleX[i] = rng.uniform(0.05f, 0.9f - std::abs(x));
+      spheres.scaleZ[i] = rng.uniform(0.05f, 0.9f - std::abs(z));
+      spheres.cycleOffset[i] = rng.uniform(0.0f, 360.0f);
+      spheres.colorR[i] = rng.uniform(0.4f, 0.95f);
+      spheres.colorG[i] = rng.uniform(0.4f, 0.95f);
+      spheres.colorB[i] = rng.uniform(0.4f, 0.95f);
+      spheres.speed[i] = static_cast<float>(10 + rng.below(41));
+      spheres.radius[i] = SphereData{}.radius;
+    }
+  });
+}
+
+// Sine and cosine of an angle in degrees. The angle is reduced by whole
+// quarter turns in degrees, which is exact enough for the few hundred turns
+// an orbit covers, and the remainder of at most 45 degrees goes through the
+// minimax polynomials of Cephes' sinf and cosf. The vector kernel below does
+// the same steps eight lanes at a time.
+static constexpr auto radiansPerDegree{0.017453292519943295f};
+static constexpr std::array<float, 3> sinCoefficients{
+    -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f};
+static constexpr std::array<float, 3> cosCoefficients{
+    4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f};
+
+static void sinCosDegrees(const float& degrees, float& sine, float& cosine) {
+  const auto quarterTurns{static_cast<int32_t>(
+      degrees * (1.0f / 90.0f) + (degrees < 0.0f ? -0.5f : 0.5f))};
+  const auto x{(degrees - static_cast<float>(quarterTurns) * 90.0f) *
+               radiansPerDegree};
+  const auto x2{x * x};
+
+  const auto s{
+      x + x * x2 *
+              (sinCoefficients[0] +
+               x2 * (sinCoefficients[1] + x2 * sinCoefficients[2]))};
+  const auto c{1.0f - 0.5f * x2 +
+               x2 * x2 *
+                   (cosCoefficients[0] +
+                    x2 * (cosCoefficients[1] + x2 * cosCoefficients[2]))};
+
+  // Odd quarter turns swap sine and cosine, and the quadrant sets the signs.
+  const auto isOdd{(quarterTurns & 1) != 0};
+  sine = (isOdd ? c : s) * static_cast<float>(1 - (quarterTurns & 2));
+  cosine = (isOdd ? s : c) * static_cast<float>(1 - ((quarterTurns + 1) & 2));
+}
+
+#ifdef SPHERE_STORE_AVX2
+static void sinCosDegrees(const __m256& degrees, __m256& sine,
+                          __m256& cosine) {
+  const auto quarterTurns{_mm256_round_ps(
+      _mm256_mul_ps(degrees, _mm256_set1_ps(1.0f / 90.0f)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+  const auto x{_mm256_mul_ps(
+      _mm256_sub_ps(degrees,
+                    _mm256_mul_ps(quarterTurns, _mm256_set1_ps(90.0f))),
+      _mm256_set1_ps(radiansPerDegree))};
+  const auto x2{_mm256_mul_ps(x, x)};
+
+  auto s{_mm256_add_ps(
+      _mm256_set1_ps(sinCoefficients[1]),
+      _mm256_mul_ps(x2, _mm256_set1_ps(sinCoefficients[2])))};
+  s = _mm256_add_ps(_mm256_set1_ps(sinCoefficients[0]), _mm256_mul_ps(x2, s));
+  s = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x, x2), s));
+
+  auto c{_mm256_add_ps(
+      _mm256_set1_ps(cosCoefficients[1]),
+      _mm256_mul_ps(x2, _mm256_set1_ps(cosCoefficients[2])))};
+  c = _mm256_add_ps(_mm256_set1_ps(cosCoefficients[0]), _mm256_mul_ps(x2, c));
+  c = _mm256_add_ps(
+      _mm256_sub_ps(_mm256_set1_ps(1.0f),
+                    _mm256_mul_ps(_mm256_set1_ps(0.5f), x2)),
+      _mm256_mul_ps(_mm256_mul_ps(x2, x2), c));
+
+  // Odd quarter turns swap sine and cosine, and the quadrant sets the sign
+  // bits.
+  const auto quadrant{_mm256_cvtps_epi32(quarterTurns)};
+  const auto isOdd{_mm256_castsi256_ps(_mm256_slli_epi32(quadrant, 31))};
+  const auto sineSign{_mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_srli_epi32(quadrant, 1), 31))};
+  const auto cosineSign{_mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_srli_epi32(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), 1),
+      31))};
+
+  sine = _mm256_xor_ps(_mm256_blendv_ps(s, c, isOdd), sineSign);
+  cosine = _mm256_xor_ps(_mm256_blendv_ps(c, s, isOdd), cosineSign);
+}
+#endif
+
+// Moves the spheres in [first, last) to where their orbits put them at the
+// given time. The time is copied first, since a reference into the store
+// would otherwise have to be reloaded after every write.
+void animateSpheres(SphereStore& spheres, const float& _time,
+                    const size_t& first, const size_t& last) {
+  const auto time{_time};
+  auto i{first};
+
+#ifdef SPHERE_STORE_AVX2
+  const auto time8{_mm256_set1_ps(time)};
+  for (; i + 8 <= last; i += 8) {
+    const auto degrees{
+        _mm256_add_ps(_mm256_mul_ps(time8, _mm256_loadu_ps(&spheres.speed[i])),
+                      _mm256_loadu_ps(&spheres.cycleOffset[i]))};
+    __m256 sine, cosine;
+    sinCosDegrees(degrees, sine, cosine);
+
+    _mm256_storeu_ps(
+        &spheres.positionX[i],
+        _mm256_add_ps(_mm256_loadu_ps(&spheres.originX[i]),
+                      _mm256_mul_ps(sine,
+                                    _mm256_loadu_ps(&spheres.scaleX[i]))));
+    _mm256_storeu_ps(
+        &spheres.positionZ[i],
+        _mm256_add_ps(_mm256_loadu_ps(&spheres.originZ[i]),
+                      _mm256_mul_ps(cosine,
+                                    _mm256_loadu_ps(&spheres.scaleZ[i]))));
+  }
+#endif
+
+  for (; i < last; i++) {
+    float sine, cosine;
+    sinCosDegrees(time * spheres.speed[i] + spheres.cycleOffset[i], sine,
+                  cosine);
+    spheres.positionX[i] = spheres.originX[i] + sine * spheres.scaleX[i];
+    spheres.positionZ[i] = spheres.originZ[i] + cosine * spheres.scaleZ[i];
+  }
+}
+
+// Large sets are split into chunks animated on every hardware thread; a set
+// of one chunk or less stays on the calling thread.
+void animateSpheres(SphereStore& spheres, const float& time) {
+  constexpr size_t chunkSize{16384};
+  parallelFor(spheres.size(), chunkSize,
+              [&](const size_t& first, const size_t& last) {
+                animateSpheres(spheres, time, first, last);
+              });
+}
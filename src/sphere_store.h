@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "counter_rng.h"
+#include "parallel_for.h"
+#include "sphere.h"
+
+// A sphere going around an ellipse in the xz plane: cycleOffset is its phase
+// in degrees and speed how many degrees it turns per second.
+struct AnimatedSphereData {
+  glm::vec3 originalPosition;
+  glm::vec3 movingScale;
+  float cycleOffset;
+  SphereData sphereData;
+  float speed;
+};
+
+// The animated spheres of a scene with one array per field, so the animation
+// kernel reads and writes whole registers of consecutive spheres. Only the
+// position arrays change once the spheres are added.
+struct SphereStore {
+  std::vector<float> originX;
+  std::vector<float> originY;
+  std::vector<float> originZ;
+  std::vector<float> scaleX;
+  std::vector<float> scaleZ;
+  std::vector<float> cycleOffset;
+  std::vector<float> speed;
+  std::vector<float> radius;
+  std::vector<float> colorR;
+  std::vector<float> colorG;
+  std::vector<float> colorB;
+  std::vector<float> positionX;
+  std::vector<float> positionY;
+  std::vector<float> positionZ;
+
+  size_t size() const noexcept;
+  void add(const AnimatedSphereData& sphere);
+  void resize(const size_t& count);
+};
+
+void generateSpheres(SphereStore& spheres, const uint64_t& seed,
+                     const size_t& count);
+
+void animateSpheres(SphereStore& spheres, const float& time);
+void animateSpheres(SphereStore& spheres, const float& time,
+                    const size_t& first, const size_t& last);
@@ -0,0 +1,102 @@
+#include "static_batch.h"
+
+StaticBatch::StaticBatch(const TextureProvider& textureProvider)
+    : textureProvider(textureProvider){};
+
+// Every four vertices form a quad that used to be drawn as a triangle fan,
+// so each one becomes the two triangles of that fan.
+void StaticBatch::add(std::span<const TexturedVertex> quads,
+                      const glm::mat4& model) {
+  const auto normalMatrix{glm::mat3{model}};
+  const auto firstVertex{vertices.size()};
+  const auto firstIndex{static_cast<GLint>(indices.size())};
+
+  for (size_t i = 0; i + 3 < quads.size(); i += 4) {
+    const auto base{static_cast<GLuint>(vertices.size())};
+    for (size_t j = 0; j < 4; j++) {
+      const auto& vertex{quads[i + j]};
+      vertices.push_back(
+          {.position{glm::vec3{model * glm::vec4{vertex.position, 1.0f}}},
+           .textureCoordinate{vertex.textureCoordinate},
+           .normal{glm::normalize(normalMatrix * vertex.normal)}});
+    }
+    indices.insert(indices.end(),
+                   {base, base + 1, base + 2, base, base + 2, base + 3});
+  }
+
+  auto lower{vertices[firstVertex].position}, upper{lower};
+  for (size_t i = firstVertex; i < vertices.size(); i++) {
+    lower = glm::min(lower, vertices[i].position);
+    upper = glm::max(upper, vertices[i].position);
+  }
+  chunks.push_back(
+      {.first{firstIndex},
+       .count{static_cast<GLsizei>(indices.size()) - firstIndex}});
+  chunkBounds.push_back(BoundingSphere{(lower + upper) / 2.0f,
+                                       glm::length(upper - lower) / 2.0f});
+}
+
+// Moves the baked geometry to the GPU and drops the CPU copy; nothing can be
+// added afterwards.
+void StaticBatch::upload() {
+  glGenVertexArrays(1, &vao);
+  RenderState::bindVertexArray(vao);
+
+  GLuint vbo{};
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(TexturedVertex),
+               vertices.data(), GL_STATIC_DRAW);
+
+  GLuint ebo{};
+  glGenBuffers(1, &ebo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+               indices.data(), GL_STATIC_DRAW);
+
+  glVertexAttribPointer(0, sizeof(TexturedVertex::position) / sizeof(GLfloat),
+                        GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
+                        (GLvoid*)offsetof(TexturedVertex, position));
+  glVertexAttribPointer(
+      1, sizeof(TexturedVertex::textureCoordinate) / sizeof(GLfloat), GL_FLOAT,
+      GL_FALSE, sizeof(TexturedVertex),
+      (GLvoid*)offsetof(TexturedVertex, textureCoordinate));
+  glVertexAttribPointer(2, sizeof(TexturedVertex::normal) / sizeof(GLfloat),
+                        GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
+                        (GLvoid*)offsetof(TexturedVertex, normal));
+
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+
+  vertices = {};
+  indices = {};
+}
+
+// Pushes one packet per run of consecutive visible meshes, centered on the
+// middle of the run.
+void StaticBatch::enqueue(RenderQueue& queue) const {
+  const auto visible{queue.cull(chunkBounds)};
+
+  for (size_t i = 0; i < chunks.size();) {
+    if (!visible[i]) {
+      i++;
+      continue;
+    }
+
+    auto last{i};
+    while (last + 1 < chunks.size() && visible[last + 1]) last++;
+    const auto center{glm::vec3{chunkBounds[i] + chunkBounds[last]} / 2.0f};
+
+    queue.push({.program{queue.programOf(shaderProgramProvider)},
+                .vao{vao},
+                .texture{textureProvider.texture()},
+                .indexed{true},
+                .first{chunks[i].first},
+                .count{chunks[last].first + chunks[last].count -
+                       chunks[i].first},
+                .instanceCount{queue.viewCount()},
+                .center{center}});
+    i = last + 1;
+  }
+};
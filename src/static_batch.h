@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "render_queue.h"
+#include "shader.h"
+#include "texture.h"
+
+struct TexturedVertex {
+  glm::vec3 position;
+  glm::vec2 textureCoordinate;
+  glm::vec3 normal;
+};
+
+// Static geometry sharing one texture, pre-transformed into world space at
+// scene build time. Meshes are added as runs of quads, which are triangulated
+// into a single index buffer. Every mesh keeps its bounding sphere and index
+// range, so after culling the visible meshes that are adjacent in the buffer
+// are still drawn together.
+class StaticBatch {
+public:
+  StaticBatch(const TextureProvider& textureProvider);
+  void add(std::span<const TexturedVertex> quads, const glm::mat4& model);
+  void upload();
+  void enqueue(RenderQueue& queue) const;
+
+private:
+  struct Chunk {
+    GLint first;
+    GLsizei count;
+  };
+
+  static inline const TextureLightingShaderProgramProvider
+      shaderProgramProvider{};
+  const TextureProvider& textureProvider;
+
+  std::vector<TexturedVertex> vertices{};
+  std::vector<GLuint> indices{};
+  GLuint vao{};
+  std::vector<Chunk> chunks{};
+  std::vector<BoundingSphere> chunkBounds{};
+};
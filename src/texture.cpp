@@ -3,20 +3,21 @@
 
 TextureProvider::TextureProvider(std::string fileName) : _fileName(fileName){};
 const GLuint& TextureProvider::texture() const {
-  if (glIsTexture(_texture) == GL_TRUE) return _texture;
+  if (_texture != 0) [[likely]] return _texture;
 
   glGenTextures(1, &_texture);
-  glBindTexture(GL_TEXTURE_2D, _texture);
+  RenderState::bindTexture(_texture);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
                   GL_NEAREST_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-                  GL_NEAREST_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
   int imageWidth{}, imageHeight{}, imageChannels{};
   unsigned char* imageData = stbi_load(_fileName.c_str(), &imageWidth,
                                        &imageHeight, &imageChannels, 0);
   if (!imageData) {
     glDeleteTextures(1, &_texture);
+    _texture = 0;
+    RenderState::invalidate();
     throw std::runtime_error("No such file: " + _fileName);
   }
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imageWidth, imageHeight, 0, GL_RGB,
@@ -5,6 +5,8 @@
 #include <stdexcept>
 #include <string>
 
+#include "render_state.h"
+
 class TextureProvider {
 public:
   TextureProvider(std::string fileName);
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest value from one writer thread to one reader thread without
+// either of them ever waiting. The writer fills back() and publishes it,
+// which swaps it with the middle slot; read swaps the middle slot to the
+// front whenever it holds something newer than the front. Slots are reused,
+// so the writer has to rewrite every field it changes on each publish.
+template <typename T> class TripleBuffer {
+public:
+  explicit TripleBuffer(const T& value) : slots{value, value, value} {}
+
+  T& back() noexcept { return slots[backIndex]; }
+
+  void publish() noexcept {
+    backIndex = middle.exchange(backIndex | freshBit) & indexMask;
+  }
+
+  const T& read() noexcept {
+    if (middle.load(std::memory_order_relaxed) & freshBit)
+      frontIndex = middle.exchange(frontIndex) & indexMask;
+    return slots[frontIndex];
+  }
+
+  const T& front() const noexcept { return slots[frontIndex]; }
+
+private:
+  static constexpr uint8_t indexMask{3};
+  static constexpr uint8_t freshBit{4};
+
+  std::array<T, 3> slots;
+  uint8_t backIndex{0};
+  std::atomic<uint8_t> middle{1};
+  uint8_t frontIndex{2};
+};
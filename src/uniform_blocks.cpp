@@ -0,0 +1,64 @@
+#include "uniform_blocks.h"
+
+void CameraUniformBuffer::setView(const size_t& slot, const glm::mat4& view,
+                                  const glm::mat4& proj,
+                                  const glm::vec3& viewPosition,
+                                  const GLsizei& viewportHeight) {
+  block.views[slot] = view;
+  block.projs[slot] = proj;
+  block.viewPositions[slot] = glm::vec4{viewPosition, 1.0f};
+  _viewportHeights[slot] = viewportHeight;
+}
+
+void CameraUniformBuffer::upload(const GLsizei& viewCount) {
+  if (ubo == 0) {
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr,
+                 GL_DYNAMIC_DRAW);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, offsetof(CameraBlock, views),
+                  viewCount * sizeof(glm::mat4), block.views.data());
+  glBufferSubData(GL_UNIFORM_BUFFER, offsetof(CameraBlock, projs),
+                  viewCount * sizeof(glm::mat4), block.projs.data());
+  glBufferSubData(GL_UNIFORM_BUFFER, offsetof(CameraBlock, viewPositions),
+                  viewCount * sizeof(glm::vec4), block.viewPositions.data());
+  glBindBufferBase(GL_UNIFORM_BUFFER, cameraBlockBinding, ubo);
+}
+
+const CameraBlock& CameraUniformBuffer::cameraBlock() const noexcept {
+  return block;
+}
+
+const std::array<GLsizei, CameraUniformBuffer::maxViews>&
+CameraUniformBuffer::viewportHeights() const noexcept {
+  return _viewportHeights;
+}
+
+void LightUniformBuffer::upload(const LightBlock& block) {
+  if (ubo == 0) {
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr,
+                 GL_DYNAMIC_DRAW);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &block);
+  glBindBufferBase(GL_UNIFORM_BUFFER, lightBlockBinding, ubo);
+}
+
+void CullUniformBuffer::upload(const CullBlock& block) {
+  if (ubo == 0) {
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CullBlock), nullptr,
+                 GL_DYNAMIC_DRAW);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CullBlock), &block);
+  glBindBufferBase(GL_UNIFORM_BUFFER, cullBlockBinding, ubo);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shader.h"
+
+// Mirrors the std140 Camera uniform block declared by the vertex shaders.
+// Single-view draws read slot 0; multi-view draws read one slot per view.
+struct CameraBlock {
+  std::array<glm::mat4, 16> views;
+  std::array<glm::mat4, 16> projs;
+  std::array<glm::vec4, 16> viewPositions;
+};
+
+// Mirrors the std140 Light uniform block declared by the lighting shaders.
+struct LightBlock {
+  glm::vec3 position;
+  GLfloat luminousIntensity;
+  alignas(16) glm::vec3 ambient;
+  alignas(16) glm::vec3 diffuse;
+  alignas(16) glm::vec3 specular;
+};
+
+// Mirrors the std140 Cull uniform block declared by sphere_cull.comp: six
+// planes per view, each view's eye with its pixel scale in w, and the
+// level radii already scaled by the LOD bias with the drop radius in w.
+struct CullBlock {
+  std::array<glm::vec4, 16 * 6> planes;
+  std::array<glm::vec4, 16> eyePositionScales;
+  glm::vec4 levelRadii;
+  GLint viewCount;
+  GLuint instanceCount;
+  GLuint levelCapacity;
+};
+
+// Per-view camera state shared by every program through cameraBlockBinding.
+// Views are staged with setView and only the used slots are uploaded. The
+// viewport height of each view stays on the CPU, where it turns sizes in
+// world space into pixels.
+class CameraUniformBuffer {
+public:
+  static constexpr size_t maxViews{16};
+  void setView(const size_t& slot, const glm::mat4& view,
+               const glm::mat4& proj, const glm::vec3& viewPosition,
+               const GLsizei& viewportHeight);
+  void upload(const GLsizei& viewCount);
+  const CameraBlock& cameraBlock() const noexcept;
+  const std::array<GLsizei, maxViews>& viewportHeights() const noexcept;
+
+private:
+  GLuint ubo{};
+  CameraBlock block{};
+  std::array<GLsizei, maxViews> _viewportHeights{};
+};
+
+// Per-frame light state shared by the lighting programs through
+// lightBlockBinding.
+class LightUniformBuffer {
+public:
+  void upload(const LightBlock& block);
+
+private:
+  GLuint ubo{};
+};
+
+// Culling parameters of the views being rendered, bound to cullBlockBinding
+// for the compute pass that culls the spheres.
+class CullUniformBuffer {
+public:
+  void upload(const CullBlock& block);
+
+private:
+  GLuint ubo{};
+};
@@ -1,42 +1,37 @@
 #include "user_control.h"
 
-FirstPersonController::FirstPersonController(GLFWwindow* window,
-                                             const glm::vec3& position)
-    : window{window}, _position{position} {
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+FirstPersonController::FirstPersonController(const glm::vec3& position)
+    : _position{position} {
+  updateView();
 };
 
 const glm::mat4& FirstPersonController::view() const { return _view; };
 
 const glm::vec3& FirstPersonController::position() const { return _position; };
 
-const double FirstPersonController::horizontalAngleRadians() {
+const double FirstPersonController::horizontalAngleRadians() const {
   return userData.horizontalAngleRadians;
 };
 
-const double FirstPersonController::verticalAngleRadians() {
+const double FirstPersonController::verticalAngleRadians() const {
   return userData.verticalAngleRadians;
 };
 
-void FirstPersonController::updateView() {
-  double xPos{}, yPos{};
-  glfwGetCursorPos(window, &xPos, &yPos);
-  int windowWidth{}, windowHeight{};
-  glfwGetWindowSize(window, &windowWidth, &windowHeight);
-
-  const auto xDelta{0.5 * windowWidth - xPos};
-  const auto yDelta{0.5 * windowHeight - yPos};
-
+void FirstPersonController::look(const double& xDelta, const double& yDelta) {
   float mouseSpeed{0.005f};
 
-  userData.horizontalAngleRadians = mouseSpeed * xDelta;
-  userData.verticalAngleRadians = mouseSpeed * yDelta;
+  userData.horizontalAngleRadians -= mouseSpeed * xDelta;
+  userData.verticalAngleRadians -= mouseSpeed * yDelta;
 
   if (userData.verticalAngleRadians >= (80.0 * M_PI / 180.0))
     userData.verticalAngleRadians = 80.0 * M_PI / 180.0;
   if (userData.verticalAngleRadians <= (-70.0 * M_PI / 180.0))
     userData.verticalAngleRadians = -70.0 * M_PI / 180.0;
 
+  updateView();
+}
+
+void FirstPersonController::updateView() {
   const glm::vec3 _direction{std::cos(userData.verticalAngleRadians) *
                                  std::sin(userData.horizontalAngleRadians),
                              std::sin(userData.verticalAngleRadians),
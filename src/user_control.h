@@ -13,17 +13,18 @@ struct UserControlData {
 
 class FirstPersonController {
 public:
-  FirstPersonController(GLFWwindow* window, const glm::vec3& position);
+  FirstPersonController(const glm::vec3& position);
   const glm::mat4& view() const;
   const glm::vec3& position() const;
-  const double horizontalAngleRadians();
-  const double verticalAngleRadians();
-  void updateView();
+  const double horizontalAngleRadians() const;
+  const double verticalAngleRadians() const;
+  void look(const double& xDelta, const double& yDelta);
   const UserControlData& getUserData();
 
 private:
-  GLFWwindow* window{};
   glm::mat4 _view{};
   glm::vec3 _position{};
   UserControlData userData{};
+
+  void updateView();
 };
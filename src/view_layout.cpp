@@ -0,0 +1,117 @@
+#include "view_layout.h"
+
+static const glm::mat4 perspectiveFor(const ViewportRect& rect);
+
+void ViewLayout::update(const QuadTree& quadTree, const int& framebufferWidth,
+                        const int& framebufferHeight) {
+  if (isValid && cachedWidth == framebufferWidth &&
+      cachedHeight == framebufferHeight &&
+      cachedVersion == quadTree.version()) [[likely]]
+    return;
+
+  isValid = true;
+  cachedWidth = framebufferWidth;
+  cachedHeight = framebufferHeight;
+  cachedVersion = quadTree.version();
+
+  _windowRect = {0, 0, framebufferWidth, framebufferHeight};
+  _windowProjection = perspectiveFor(_windowRect);
+
+  // Edges are rounded rather than truncated so neighbouring views share
+  // their border pixel instead of leaving a gap between them.
+  const auto leaves{quadTree.leaves()};
+  _rects.resize(leaves.size());
+  _projections.resize(leaves.size());
+  _allLeaves.resize(leaves.size());
+  for (size_t i = 0; i < leaves.size(); i++) {
+    _allLeaves[i] = static_cast<uint32_t>(i);
+
+    const auto left{std::lround(leaves.x[i] * framebufferWidth)};
+    const auto bottom{std::lround(leaves.y[i] * framebufferHeight)};
+    const auto right{
+        std::lround((leaves.x[i] + leaves.width[i]) * framebufferWidth)};
+    const auto top{
+        std::lround((leaves.y[i] + leaves.height[i]) * framebufferHeight)};
+
+    _rects[i] = {static_cast<GLint>(left), static_cast<GLint>(bottom),
+                 static_cast<GLsizei>(right - left),
+                 static_cast<GLsizei>(top - bottom)};
+    _projections[i] = perspectiveFor(_rects[i]);
+  }
+
+  groupSharedViews(leaves);
+}
+
+std::span<const ViewportRect> ViewLayout::rects() const noexcept {
+  return _rects;
+}
+
+std::span<const glm::mat4> ViewLayout::projections() const noexcept {
+  return _projections;
+}
+
+const ViewportRect& ViewLayout::windowRect() const noexcept {
+  return _windowRect;
+}
+
+const glm::mat4& ViewLayout::windowProjection() const noexcept {
+  return _windowProjection;
+}
+
+std::span<const uint32_t> ViewLayout::allLeaves() const noexcept {
+  return _allLeaves;
+}
+
+std::span<const uint32_t> ViewLayout::sourceLeaves() const noexcept {
+  return _sourceLeaves;
+}
+
+std::span<const SharedView> ViewLayout::sharedViews() const noexcept {
+  return _sharedViews;
+}
+
+// Leaves that share a camera and an aspect ratio see the same image at
+// different scales, so only the largest of them needs the scene rendered;
+// the others are filled by scaling its pixels. Splits only ever halve a
+// rect, so the normalized aspect ratios compare exactly.
+void ViewLayout::groupSharedViews(const QuadTreeLeaves& leaves) {
+  groupOrder.resize(leaves.size());
+  for (uint32_t i = 0; i < leaves.size(); i++)
+    groupOrder[i] = i;
+
+  const auto aspectRatio{[&](const uint32_t& i) {
+    return leaves.width[i] / leaves.height[i];
+  }};
+  std::sort(groupOrder.begin(), groupOrder.end(),
+            [&](const uint32_t& a, const uint32_t& b) {
+              if (leaves.controllerIdx[a] != leaves.controllerIdx[b])
+                return leaves.controllerIdx[a] < leaves.controllerIdx[b];
+              if (aspectRatio(a) != aspectRatio(b))
+                return aspectRatio(a) < aspectRatio(b);
+              return leaves.width[a] > leaves.width[b];
+            });
+
+  _sourceLeaves.clear();
+  _sharedViews.clear();
+  for (size_t i = 0; i < groupOrder.size(); i++) {
+    const auto leaf{groupOrder[i]};
+    if (i > 0) {
+      const auto source{_sourceLeaves.back()};
+      if (leaves.controllerIdx[leaf] == leaves.controllerIdx[source] &&
+          aspectRatio(leaf) == aspectRatio(source)) {
+        _sharedViews.push_back({.sourceLeaf{source}, .targetLeaf{leaf}});
+        continue;
+      }
+    }
+    _sourceLeaves.push_back(leaf);
+  }
+}
+
+static const glm::mat4 perspectiveFor(const ViewportRect& rect) {
+  // A minimized window reports a zero-sized framebuffer; keep the matrix
+  // finite so nothing downstream has to special-case it.
+  const auto aspectRatio{rect.height > 0 ? static_cast<float>(rect.width) /
+                                               rect.height
+                                         : 1.0f};
+  return glm::perspective(glm::radians(45.0f), aspectRatio, 0.01f, 100.0f);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "quad_tree.h"
+
+struct ViewportRect {
+  GLint x;
+  GLint y;
+  GLsizei width;
+  GLsizei height;
+};
+
+// A leaf whose image is copied from another leaf looking through the same
+// camera with the same aspect ratio.
+struct SharedView {
+  uint32_t sourceLeaf;
+  uint32_t targetLeaf;
+};
+
+// Pixel rects and projection matrices for every leaf of a QuadTree, indexed
+// like QuadTree::leaves(), plus the whole framebuffer for the bird view. The
+// cache is keyed on the framebuffer size and the tree version, so it is only
+// rebuilt when the window resizes or the tree is split or merged.
+class ViewLayout {
+public:
+  void update(const QuadTree& quadTree, const int& framebufferWidth,
+              const int& framebufferHeight);
+  std::span<const ViewportRect> rects() const noexcept;
+  std::span<const glm::mat4> projections() const noexcept;
+  const ViewportRect& windowRect() const noexcept;
+  const glm::mat4& windowProjection() const noexcept;
+  std::span<const uint32_t> allLeaves() const noexcept;
+  std::span<const uint32_t> sourceLeaves() const noexcept;
+  std::span<const SharedView> sharedViews() const noexcept;
+
+private:
+  bool isValid{false};
+  int cachedWidth{};
+  int cachedHeight{};
+  uint64_t cachedVersion{};
+
+  std::vector<ViewportRect> _rects{};
+  std::vector<glm::mat4> _projections{};
+  ViewportRect _windowRect{};
+  glm::mat4 _windowProjection{1.0};
+
+  std::vector<uint32_t> _allLeaves{};
+  std::vector<uint32_t> _sourceLeaves{};
+  std::vector<SharedView> _sharedViews{};
+  std::vector<uint32_t> groupOrder{};
+
+  void groupSharedViews(const QuadTreeLeaves& leaves);
+};
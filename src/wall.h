@@ -1,35 +1,22 @@
 #pragma once
 #include <array>
-#include <cstddef>
-#include <string>
 
-#include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "shader.h"
-#include "texture.h"
-
-class WallVaoProvider {
-public:
-  const GLuint& vao() const;
-
-private:
-  mutable GLuint _vao{};
-};
+#include "static_batch.h"
 
+// Static piece of the room. It is never drawn on its own; the scene bakes it
+// into the StaticBatch of its texture.
 class WallComponent {
 public:
+  static constexpr char textureFile[]{"textures/tile1.jpeg"};
+
   WallComponent(const glm::vec3& position, const bool& rotate90Deg);
-  void render(const glm::mat4& view, const glm::mat4& proj,
-              const glm::vec3& viewPosition,
-              const glm::vec3& lightPosition) const;
+  WallComponent(const glm::mat4& model);
+  const glm::mat4& model() const noexcept;
+  void bake(StaticBatch& batch) const;
 
 private:
-  static inline const TextureLightingShaderProgramProvider
-      shaderProgramProvider{};
-  static inline const WallVaoProvider vaoProvider{};
-  static inline const TextureProvider textureProvider{
-      std::string("textures/tile1.jpeg")};
-
-  glm::mat4 model{1.0};
+  static const std::array<TexturedVertex, 24> vertices;
+  glm::mat4 _model{1.0};
 };